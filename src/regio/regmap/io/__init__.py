@@ -1,17 +1,33 @@
 #---------------------------------------------------------------------------------------------------
 __all__ = (
+    'CachedIO',
     'DevMmapIO',
     'DevMmapIOForSpec',
     'DictIO',
+    'Doorbell',
     'FileMmapIO',
     'FileMmapIOForSpec',
     'FileStreamIO',
     'FileStreamIOForSpec',
     'ListIO',
     'ListIOForSpec',
+    'RegisterServer',
+    'RemoteError',
+    'RemoteIO',
+    'ReplayError',
+    'ReplayIO',
+    'ShmIO',
+    'ShmIOForSpec',
+    'ThreadedIO',
+    'TracingIO',
     'ZeroIO',
 )
 
+from .aio import ThreadedIO
+from .cache import CachedIO
 from .io import DictIO, ListIO, ListIOForSpec, ZeroIO
 from .mmap import DevMmapIO, DevMmapIOForSpec, FileMmapIO, FileMmapIOForSpec
+from .remote import RegisterServer, RemoteError, RemoteIO
+from .shm import Doorbell, ShmIO, ShmIOForSpec
 from .stream import FileStreamIO, FileStreamIOForSpec
+from .trace import ReplayError, ReplayIO, TracingIO
@@ -0,0 +1,97 @@
+#---------------------------------------------------------------------------------------------------
+__all__ = ()
+
+import asyncio
+import concurrent.futures
+
+from . import io
+
+#---------------------------------------------------------------------------------------------------
+# Offloads the accesses of the awaitable interface onto a pool of threads, such that up to jobs
+# accesses are in flight at once. The synchronous interface is passed straight through. The wrapped
+# IO must be shareable between threads (such as memory mapped IO, which releases the GIL around its
+# accesses), and accesses issued concurrently complete in no particular order. Awaiting each access
+# before issuing the next one keeps them ordered.
+class ThreadedIO(io.IO):
+    def __init__(self, llio, jobs=8, *pargs, **kargs):
+        super().__init__(*pargs, **kargs)
+
+        if jobs < 1:
+            raise ValueError(f'Number of jobs {jobs} must be at least 1.')
+
+        self.llio = llio
+        self.jobs = jobs
+
+    def __getattr__(self, name):
+        # Expose the attributes of the wrapped IO (such as the data width), so the wrapper can stand
+        # in for it.
+        if name == 'llio':
+            raise AttributeError(name)
+        return getattr(self.llio, name)
+
+    def start(self):
+        if not self.started:
+            self.llio.start()
+            self._executor = concurrent.futures.ThreadPoolExecutor(
+                max_workers=self.jobs, thread_name_prefix='regio-io')
+            super().start()
+
+    def stop(self):
+        if self.started:
+            # Let accesses still in flight complete before the wrapped IO is stopped.
+            self._executor.shutdown(wait=True)
+            del self._executor
+            self.llio.stop()
+            super().stop()
+
+    def _submit(self, func, *pargs):
+        return asyncio.get_running_loop().run_in_executor(self._executor, func, *pargs)
+
+    #-----------------------------------------------------------------------------------------------
+    def read(self, offset, size):
+        return self.llio.read(offset, size)
+
+    def write(self, offset, size, value):
+        self.llio.write(offset, size, value)
+
+    def update(self, offset, size, clr_mask, set_mask):
+        self.llio.update(offset, size, clr_mask, set_mask)
+
+    def read_many(self, offsets, sizes, out=None):
+        return self.llio.read_many(offsets, sizes, out)
+
+    def write_many(self, offsets, sizes, values, barrier=False):
+        self.llio.write_many(offsets, sizes, values, barrier)
+
+    def update_many(self, offsets, sizes, clr_masks, set_masks, barrier=False):
+        self.llio.update_many(offsets, sizes, clr_masks, set_masks, barrier)
+
+    def write_combined(self, offsets, sizes, values):
+        self.llio.write_combined(offsets, sizes, values)
+
+    def poll_until(self, offset, size, mask, value, timeout=None, backoff=1e-3):
+        return self.llio.poll_until(offset, size, mask, value, timeout, backoff)
+
+    #-----------------------------------------------------------------------------------------------
+    async def aread(self, offset, size):
+        return await self._submit(self.llio.read, offset, size)
+
+    async def awrite(self, offset, size, value):
+        await self._submit(self.llio.write, offset, size, value)
+
+    async def aupdate(self, offset, size, clr_mask, set_mask):
+        await self._submit(self.llio.update, offset, size, clr_mask, set_mask)
+
+    async def aread_many(self, offsets, sizes, out=None):
+        return await self._submit(self.llio.read_many, offsets, sizes, out)
+
+    async def awrite_many(self, offsets, sizes, values, barrier=False):
+        await self._submit(self.llio.write_many, offsets, sizes, values, barrier)
+
+    async def aupdate_many(self, offsets, sizes, clr_masks, set_masks, barrier=False):
+        await self._submit(self.llio.update_many, offsets, sizes, clr_masks, set_masks, barrier)
+
+    async def apoll_until(self, offset, size, mask, value, timeout=None, backoff=1e-3):
+        # Polling occupies one of the threads until done.
+        return await self._submit(
+            self.llio.poll_until, offset, size, mask, value, timeout, backoff)
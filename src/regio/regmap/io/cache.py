@@ -0,0 +1,169 @@
+#---------------------------------------------------------------------------------------------------
+__all__ = ()
+
+from . import io
+from ..spec import info
+from ..spec.register import Caching
+
+#---------------------------------------------------------------------------------------------------
+# Caches the values of registers read through a wrapped IO, following the caching policy of each
+# register in the regmap specification (see register.Caching). Read-write registers are cached with
+# write-through, constant registers are read only once and all other registers are always accessed.
+# The policy is looked up when an offset is first accessed. Accesses which don't match a register
+# exactly (such as the multi-register runs of buffered IO) aren't cached, with writes dropping any
+# cached registers they overlap.
+#
+# The cache is cleared each time the IO is started. Call invalidate after anything which changes
+# the device's registers behind the cache's back (such as a reset, or another process). The cache is
+# kept in Python containers, so the wrapper must only be used by one thread at a time.
+class CachedIO(io.IO):
+    def __init__(self, llio, spec, *pargs, **kargs):
+        super().__init__(*pargs, **kargs)
+
+        self.llio = llio
+        self.spec = spec
+        self._policies = {} # Offset to (size, caching, mask) of the register at the offset.
+        self.values = {} # Offset to cached value.
+        self._max_size = 1 # Size of the largest register which can be cached.
+        self.hits = 0
+        self.misses = 0
+
+    def __getattr__(self, name):
+        # Expose the attributes of the wrapped IO (such as the data width), so the wrapper can stand
+        # in for it.
+        if name == 'llio':
+            raise AttributeError(name)
+        return getattr(self.llio, name)
+
+    def start(self):
+        if not self.started:
+            self.invalidate()
+            self.llio.start()
+            super().start()
+
+    def stop(self):
+        if self.started:
+            self.llio.stop()
+            super().stop()
+
+    def invalidate(self, offset=None, size=1):
+        # Drop the cached registers overlapping the given range of words, or all of them. Cached
+        # registers may start before the range, by up to the size of the largest one.
+        values = self.values
+        if offset is None:
+            values.clear()
+        elif values:
+            policies = self._policies
+            for o in range(max(0, offset - self._max_size + 1), offset + size):
+                if o in values and o + policies[o][0] > offset:
+                    del values[o]
+
+    #-----------------------------------------------------------------------------------------------
+    def _policy(self, offset, size):
+        entry = self._policies.get(offset)
+        if entry is None:
+            entry = (None, Caching.NONE, 0)
+            node = info.register_at(self.spec, offset)
+            if node is not None and node.region.offset.absolute == offset:
+                region = node.region
+                entry = (region.size, node.caching, (1 << (region.size * region.data_width)) - 1)
+                if entry[1] is not Caching.NONE:
+                    self._max_size = max(self._max_size, region.size)
+            self._policies[offset] = entry
+
+        if entry[0] != size:
+            return Caching.NONE, 0
+        return entry[1], entry[2]
+
+    def _written(self, offset, size, value):
+        caching, mask = self._policy(offset, size)
+        if caching is Caching.WRITE_THROUGH:
+            self.values[offset] = value & mask
+        else:
+            self.invalidate(offset, size)
+
+    def _updated(self, offset, size, clr_mask, set_mask):
+        # The new value is only known when the old one was cached.
+        caching, mask = self._policy(offset, size)
+        value = self.values.get(offset)
+        if caching is Caching.WRITE_THROUGH and value is not None:
+            self.values[offset] = ((value & clr_mask) | set_mask) & mask
+        else:
+            self.invalidate(offset, size)
+
+    #-----------------------------------------------------------------------------------------------
+    def read(self, offset, size):
+        caching, _ = self._policy(offset, size)
+        if caching is Caching.NONE:
+            return self.llio.read(offset, size)
+
+        value = self.values.get(offset)
+        if value is None:
+            self.misses += 1
+            value = self.values[offset] = self.llio.read(offset, size)
+        else:
+            self.hits += 1
+        return value
+
+    def write(self, offset, size, value):
+        self.llio.write(offset, size, value)
+        self._written(offset, size, value)
+
+    def update(self, offset, size, clr_mask, set_mask):
+        self.llio.update(offset, size, clr_mask, set_mask)
+        self._updated(offset, size, clr_mask, set_mask)
+
+    def read_many(self, offsets, sizes, out=None):
+        # Serve the cached registers, reading all others with a single batch.
+        count = len(offsets)
+        sizes = list(self.broadcast('sizes', sizes, count))
+        values = [None] * count
+        misses = []
+        for i, (offset, size) in enumerate(zip(offsets, sizes)):
+            caching, _ = self._policy(offset, size)
+            if caching is not Caching.NONE:
+                values[i] = self.values.get(offset)
+            if values[i] is None:
+                misses.append(i)
+
+        self.hits += count - len(misses)
+        if misses:
+            results = self.llio.read_many([offsets[i] for i in misses], [sizes[i] for i in misses])
+            for i, value in zip(misses, results):
+                values[i] = value
+                offset = offsets[i]
+                if self._policy(offset, sizes[i])[0] is not Caching.NONE:
+                    self.misses += 1
+                    self.values[offset] = value
+        return self.fill(out, values)
+
+    def write_many(self, offsets, sizes, values, barrier=False):
+        self.llio.write_many(offsets, sizes, values, barrier)
+        self._written_many(offsets, sizes, values)
+
+    def update_many(self, offsets, sizes, clr_masks, set_masks, barrier=False):
+        self.llio.update_many(offsets, sizes, clr_masks, set_masks, barrier)
+
+        count = len(offsets)
+        sizes = self.broadcast('sizes', sizes, count)
+        clr_masks = self.broadcast('clr_masks', clr_masks, count)
+        set_masks = self.broadcast('set_masks', set_masks, count)
+        for offset, size, clr_mask, set_mask in zip(offsets, sizes, clr_masks, set_masks):
+            self._updated(offset, size, clr_mask, set_mask)
+
+    def write_combined(self, offsets, sizes, values):
+        self.llio.write_combined(offsets, sizes, values)
+        self._written_many(offsets, sizes, values)
+
+    def _written_many(self, offsets, sizes, values):
+        count = len(offsets)
+        sizes = self.broadcast('sizes', sizes, count)
+        values = self.broadcast('values', values, count)
+        for offset, size, value in zip(offsets, sizes, values):
+            self._written(offset, size, value)
+
+    def poll_until(self, offset, size, mask, value, timeout=None, backoff=1e-3):
+        # Polling waits on the device, so always bypasses the cache.
+        v = self.llio.poll_until(offset, size, mask, value, timeout, backoff)
+        self.invalidate(offset, size)
+        return v
@@ -1,8 +1,12 @@
 #---------------------------------------------------------------------------------------------------
 __all__ = ()
 
+import array
+import asyncio
 import enum
+import itertools
 import sys
+import time
 
 from ..spec import info
 
@@ -18,6 +22,16 @@ class Endian(enum.Enum):
         return self
 
 #---------------------------------------------------------------------------------------------------
+# Thread safety:
+# - Memory mapped IO objects (MmapDirectIO and its sub-classes) can be shared between threads once
+#   started. The C extension releases the GIL around accesses to the mapping, so threads accessing
+#   different devices or BARs run concurrently. Accesses from different threads are unordered, and
+#   an update is a read-modify-write which isn't atomic with respect to other threads. Starting and
+#   stopping must not race with accesses, and stopping is refused while any are in progress.
+# - All other IO objects (buffered, stream, list and dict based) keep state in Python containers or
+#   file positions, so must only be used by one thread at a time.
+# - Regmap specifications can be shared between threads, as can proxies over a shareable IO object
+#   (provided no buffering is configured). Most commonly, each thread creates its own proxies.
 class IO:
     def __init__(self, *pargs, **kargs):
         super().__init__(*pargs, **kargs)
@@ -53,6 +67,58 @@ class IO:
         value |= set_mask
         self.write(offset, size, value)
 
+    @staticmethod
+    def broadcast(name, items, count):
+        if isinstance(items, int):
+            return itertools.repeat(items, count)
+        if len(items) != count:
+            raise ValueError(
+                f'Length of {name} ({len(items)}) must match number of offsets ({count}).')
+        return items
+
+    # Batched variants of read, write and update. Each argument following the offsets can either
+    # be a sequence matching the offsets or a single int applied to all offsets. Accesses are
+    # performed in the order given. For reads, the out sequence is filled in with the results when
+    # given, otherwise they are returned as a list. For writes and updates, the barrier requests
+    # that all stores be ordered before any subsequent ones (only meaningful to memory mapped IO).
+    def read_many(self, offsets, sizes, out=None):
+        count = len(offsets)
+        sizes = self.broadcast('sizes', sizes, count)
+
+        return self.fill(out, [self.read(offset, size) for offset, size in zip(offsets, sizes)])
+
+    @staticmethod
+    def fill(out, values):
+        if out is None:
+            return values
+
+        for i, value in enumerate(values):
+            out[i] = value
+        return out
+
+    def write_many(self, offsets, sizes, values, barrier=False):
+        count = len(offsets)
+        sizes = self.broadcast('sizes', sizes, count)
+        values = self.broadcast('values', values, count)
+
+        for offset, size, value in zip(offsets, sizes, values):
+            self.write(offset, size, value)
+
+    def update_many(self, offsets, sizes, clr_masks, set_masks, barrier=False):
+        count = len(offsets)
+        sizes = self.broadcast('sizes', sizes, count)
+        clr_masks = self.broadcast('clr_masks', clr_masks, count)
+        set_masks = self.broadcast('set_masks', set_masks, count)
+
+        for offset, size, clr_mask, set_mask in zip(offsets, sizes, clr_masks, set_masks):
+            self.update(offset, size, clr_mask, set_mask)
+
+    # Batched write whose stores may be merged (and reordered amongst themselves) on their way to
+    # the device, ending with a barrier which orders them before any subsequent stores. Only memory
+    # mapped IO with a write combining mapping differs from a write_many with a barrier.
+    def write_combined(self, offsets, sizes, values):
+        self.write_many(offsets, sizes, values, barrier=True)
+
     def read_region(self, region):
         return (self.read(region.offset.absolute, region.size) >> region.shift) & region.mask
 
@@ -63,6 +129,111 @@ class IO:
         mask = region.mask << region.shift
         self.update(region.offset.absolute, region.size, ~mask, (value << region.shift) & mask)
 
+    # Read an access until the bits under mask read as value, returning the last value read. Raises
+    # a TimeoutError if timeout seconds (never when None) elapse first. The delay between reads
+    # doubles each time, up to backoff seconds. Memory mapped IO polls natively, without the GIL.
+    def poll_until(self, offset, size, mask, value, timeout=None, backoff=1e-3):
+        deadline = None if timeout is None else time.monotonic() + timeout
+        delay = 1e-6
+        while True:
+            v = self.read(offset, size)
+            if v & mask == value & mask:
+                return v
+            time.sleep(self._poll_delay(offset, mask, value, v, deadline, delay, backoff))
+            delay *= 2
+
+    @staticmethod
+    def _poll_delay(offset, mask, value, v, deadline, delay, backoff):
+        delay = min(delay, backoff)
+        if deadline is None:
+            return delay
+
+        remaining = deadline - time.monotonic()
+        if remaining <= 0:
+            raise TimeoutError(
+                f'Timed out polling offset 0x{offset:x} for 0x{value & mask:x} under mask '
+                f'0x{mask:x} (last read 0x{v:x}).')
+        return min(delay, remaining)
+
+    # Batched variant of read_region, performed with a single read_many.
+    def read_regions(self, regions, out=None):
+        regions = tuple(regions)
+        values = self.read_many(
+            [region.offset.absolute for region in regions], [region.size for region in regions])
+        return self.fill(
+            out, [(value >> r.shift) & r.mask for value, r in zip(values, regions)])
+
+    #-----------------------------------------------------------------------------------------------
+    # Awaitable variants of the interface, for use from asyncio tasks. By default, each one performs
+    # the synchronous operation in place, so no accesses overlap. Backends with real latency
+    # override the primitives (aread, awrite and aupdate, along with their batched variants) to have
+    # any number of accesses in flight at once. The region variants are layered on the primitives.
+    async def __aenter__(self):
+        await self.astart()
+
+        # Allow caller to bind the object in an 'async with X() as x' statement.
+        return self
+
+    async def __aexit__(self, *pargs):
+        await self.astop()
+
+        # Don't suppress exceptions. Pass along to the caller.
+        return False
+
+    async def astart(self):
+        self.start()
+
+    async def astop(self):
+        self.stop()
+
+    async def aread(self, offset, size):
+        return self.read(offset, size)
+
+    async def awrite(self, offset, size, value):
+        self.write(offset, size, value)
+
+    async def aupdate(self, offset, size, clr_mask, set_mask):
+        self.update(offset, size, clr_mask, set_mask)
+
+    async def aread_many(self, offsets, sizes, out=None):
+        return self.read_many(offsets, sizes, out)
+
+    async def awrite_many(self, offsets, sizes, values, barrier=False):
+        self.write_many(offsets, sizes, values, barrier)
+
+    async def aupdate_many(self, offsets, sizes, clr_masks, set_masks, barrier=False):
+        self.update_many(offsets, sizes, clr_masks, set_masks, barrier)
+
+    async def apoll_until(self, offset, size, mask, value, timeout=None, backoff=1e-3):
+        deadline = None if timeout is None else time.monotonic() + timeout
+        delay = 1e-6
+        while True:
+            v = await self.aread(offset, size)
+            if v & mask == value & mask:
+                return v
+            await asyncio.sleep(self._poll_delay(offset, mask, value, v, deadline, delay, backoff))
+            delay *= 2
+
+    async def aread_region(self, region):
+        value = await self.aread(region.offset.absolute, region.size)
+        return (value >> region.shift) & region.mask
+
+    async def awrite_region(self, region, value):
+        await self.awrite(
+            region.offset.absolute, region.size, (value & region.mask) << region.shift)
+
+    async def aupdate_region(self, region, value):
+        mask = region.mask << region.shift
+        await self.aupdate(
+            region.offset.absolute, region.size, ~mask, (value << region.shift) & mask)
+
+    async def aread_regions(self, regions, out=None):
+        regions = tuple(regions)
+        values = await self.aread_many(
+            [region.offset.absolute for region in regions], [region.size for region in regions])
+        return self.fill(
+            out, [(value >> r.shift) & r.mask for value, r in zip(values, regions)])
+
 #---------------------------------------------------------------------------------------------------
 class IOBuffer(dict):
     def sorted(self):
@@ -70,13 +241,16 @@ class IOBuffer(dict):
             yield (offset, value)
 
 #---------------------------------------------------------------------------------------------------
+# When combining, a sync stores all buffered words as a single combined write (see
+# IO.write_combined) rather than one store at a time.
 class BufferedIO(IO):
-    def __init__(self, llio, buffer=None, *pargs, **kargs):
+    def __init__(self, llio, buffer=None, combine=False, *pargs, **kargs):
         super().__init__(*pargs, **kargs)
 
         self.llio = llio
         self.buffer = IOBuffer() if buffer is None else buffer
         self.default = None
+        self.combine = combine
 
     def start(self):
         self.llio.start()
@@ -112,6 +286,15 @@ class BufferedIO(IO):
         self.store(region.offset.absolute, region.size, value)
 
     def sync(self):
+        if self.combine:
+            items = list(self.buffer.sorted())
+            if items:
+                self.llio.write_combined(
+                    [offset for offset, _ in items],
+                    [value[0] for _, value in items],
+                    [value[1] for _, value in items])
+            return
+
         for offset, value in self.buffer.sorted():
             self.store(offset, value[0], value[1])
 
@@ -122,6 +305,354 @@ class BufferedIO(IO):
         self.sync()
         self.drop()
 
+#---------------------------------------------------------------------------------------------------
+# Location of a set of registers, indexed by register ordinal (as assigned during counting). The
+# registers contained in any sub-tree of a regmap occupy a contiguous range of ordinals, so the
+# layout is kept as parallel arrays over that range rather than a mapping keyed by offset. Since a
+# layout only depends on the regmap specification, it can be shared by any number of buffers. The
+# ordered regions are those of registers whose writes have ordering sensitive side-effects, which
+# are never combined with other writes.
+class RegisterLayout:
+    def __init__(self, regions, ordered=()):
+        # Determine the range of register ordinals spanned by the given register regions. Any holes
+        # in the range (such as from a strided group of registers) are left unused.
+        regions = list(regions)
+        if regions:
+            self.first = min(region.register for region in regions)
+            self.count = max(region.register for region in regions) - self.first + 1
+        else:
+            self.first = 0
+            self.count = 0
+
+        # Capture the location of each register.
+        self.offsets = array.array('Q', bytes(8 * self.count))
+        self.sizes = array.array('L', bytes(array.array('L').itemsize * self.count))
+        self.widths = array.array('H', bytes(2 * self.count))
+        for region in regions:
+            i = region.register - self.first
+            self.offsets[i] = region.offset.absolute
+            self.sizes[i] = region.size
+            self.widths[i] = region.data_width
+
+        self.ordered = frozenset(self.ordinal(region) for region in ordered)
+        self._index = None
+
+    def __len__(self):
+        return self.count
+
+    def ordinal(self, region):
+        i = region.register - self.first
+        if i < 0 or i >= self.count or not self.sizes[i]:
+            raise ValueError(f'Register ordinal {region.register} is not contained in the layout.')
+        return i
+
+    def find(self, offset, size):
+        # Lazily index the registers by offset for the (infrequent) accesses not made by region.
+        if self._index is None:
+            self._index = dict((o, i) for i, o in enumerate(self.offsets) if self.sizes[i])
+
+        i = self._index.get(offset)
+        if i is None or self.sizes[i] != size:
+            raise ValueError(f'No register of size {size} at offset {offset} in the layout.')
+        return i
+
+    def plan(self, regions):
+        # Plan the loads for the given regions by merging registers that are adjacent in IO space
+        # into contiguous runs. Gaps between registers (padding and those which aren't part of the
+        # plan) always begin a new run, as does a change in the data width.
+        plan = RegisterLoadPlan()
+        end = width = None
+        for region in regions:
+            i = self.ordinal(region)
+            offset = self.offsets[i]
+            size = self.sizes[i]
+            if offset == end and region.data_width == width:
+                plan.sizes[-1] += size
+                plan.runs[-1].append(i)
+            else:
+                width = region.data_width
+                plan.offsets.append(offset)
+                plan.sizes.append(size)
+                plan.widths.append(width)
+                plan.runs.append([i])
+            end = offset + size
+
+        # Runs made up of consecutive single word registers can be split as an array of words.
+        for n, ordinals in enumerate(plan.runs):
+            first = ordinals[0]
+            if (plan.sizes[n] == len(ordinals) and ordinals[-1] - first + 1 == len(ordinals) and
+                plan.widths[n] in plan.WORD_FORMATS):
+                plan.runs[n] = range(first, first + len(ordinals))
+        return plan
+
+class RegisterLoadPlan:
+    WORD_FORMATS = {8: 'B', 16: 'H', 32: 'I', 64: 'Q'}
+
+    def __init__(self):
+        # Parallel lists describing each run: it's start offset, total size, data width and the
+        # ordinals of the registers it covers (in order of increasing offset). The ordinals are a
+        # range when the run is an array of consecutive single word registers.
+        self.offsets = []
+        self.sizes = []
+        self.widths = []
+        self.runs = []
+
+    def __len__(self):
+        return len(self.runs)
+
+#---------------------------------------------------------------------------------------------------
+# Dense buffer of register values for a layout. Values are held in a list since registers can be
+# wider than any array.array() type code. Modified registers are tracked in a bitmap, allowing for a
+# sync to store only those, in ordinal order and without needing to sort.
+class RegisterBuffer:
+    def __init__(self, layout):
+        self.layout = layout
+        self.offsets = layout.offsets
+        self.sizes = layout.sizes
+        self.clear()
+
+    def __len__(self):
+        return len(self.layout)
+
+    def clear(self):
+        self.values = [None] * len(self.layout)
+        self.bitmap = bytearray((len(self.layout) + 8 - 1) // 8)
+
+    def set(self, i, value):
+        self.values[i] = value
+        self.bitmap[i >> 3] |= 1 << (i & 7)
+
+    def set_clean(self, i, value):
+        self.values[i] = value
+        self.bitmap[i >> 3] &= ~(1 << (i & 7)) & 0xff
+
+    def dirty(self):
+        for n, bits in enumerate(self.bitmap):
+            while bits:
+                bit = bits & -bits
+                bits ^= bit
+                yield (n << 3) + bit.bit_length() - 1
+
+    def clean(self):
+        self.bitmap = bytearray(len(self.bitmap))
+
+#---------------------------------------------------------------------------------------------------
+# Buffered IO on a set of whole registers. All accesses are made by region, with those to fields
+# being mapped onto the register containing them. The low-level IO is only ever accessed using the
+# full extent of a register.
+class RegisterBufferedIO(BufferedIO):
+    # Longest run of registers merged into a single access when combining, limited to the size of a
+    # write combining buffer (a cache line) to bound the cost of assembling the run's value.
+    COMBINE_BITS = 512
+
+    def __init__(self, llio, layout, combine=False, *pargs, **kargs):
+        if not isinstance(layout, RegisterLayout):
+            layout = RegisterLayout(layout)
+        super().__init__(llio, RegisterBuffer(layout), combine, *pargs, **kargs)
+        self.layout = layout
+
+    def _value(self, i):
+        value = self.buffer.values[i]
+        if value is not None:
+            return value
+
+        if self.default is None:
+            return self._load(i)
+        return self.default
+
+    def _load(self, i):
+        buffer = self.buffer
+        value = self.llio.read(buffer.offsets[i], buffer.sizes[i])
+        buffer.set_clean(i, value)
+        return value
+
+    def _store(self, i, value):
+        buffer = self.buffer
+        buffer.set_clean(i, value)
+        self.llio.write(buffer.offsets[i], buffer.sizes[i], value)
+
+    def _locate(self, region):
+        # Determine the register and the bit position of the region within it. For fields, the
+        # region's offset is that of the first word in the register containing the field's bits.
+        i = self.layout.ordinal(region)
+        shift = (region.offset.absolute - self.buffer.offsets[i]) * region.data_width
+        return i, shift + region.shift
+
+    def read(self, offset, size):
+        return self._value(self.layout.find(offset, size))
+
+    def write(self, offset, size, value):
+        self.buffer.set(self.layout.find(offset, size), value)
+
+    def load(self, offset, size):
+        return self._load(self.layout.find(offset, size))
+
+    def store(self, offset, size, value):
+        self._store(self.layout.find(offset, size), value)
+
+    def read_region(self, region):
+        i, shift = self._locate(region)
+        return (self._value(i) >> shift) & region.mask
+
+    def read_regions(self, regions, out=None):
+        return self.fill(out, [self.read_region(region) for region in regions])
+
+    def write_region(self, region, value):
+        i, shift = self._locate(region)
+        value = (value & region.mask) << shift
+
+        # Writing a region that only covers some of the register's words (only possible for a field)
+        # must preserve the contents of the remaining words.
+        if region.size != self.buffer.sizes[i]:
+            words = ((1 << (region.size * region.data_width)) - 1) << (shift - region.shift)
+            value |= self._value(i) & ~words
+        self.buffer.set(i, value)
+
+    def update_region(self, region, value):
+        i, shift = self._locate(region)
+        mask = region.mask << shift
+        self.buffer.set(i, (self._value(i) & ~mask) | ((value << shift) & mask))
+
+    def load_region(self, region):
+        i, shift = self._locate(region)
+        return (self._load(i) >> shift) & region.mask
+
+    def load_regions(self, regions):
+        self.load_plan(self.layout.plan(regions))
+
+    def load_plan(self, plan):
+        # Read all runs in a single batch, then split each of them back into registers (the lowest
+        # offset is in the least significant bits). When the data width is a multiple of octets,
+        # the split is done by slicing bytes to avoid repeatedly shifting a potentially huge int.
+        if not plan:
+            return
+
+        buffer = self.buffer
+        sizes = buffer.sizes
+        dirty = any(buffer.bitmap)
+        values = self.llio.read_many(plan.offsets, plan.sizes)
+        for value, size, width, ordinals in zip(values, plan.sizes, plan.widths, plan.runs):
+            if len(ordinals) == 1:
+                buffer.set_clean(ordinals[0], value)
+            elif isinstance(ordinals, range):
+                octets = width // 8
+                words = array.array(plan.WORD_FORMATS[width])
+                words.frombytes(value.to_bytes(size * octets, 'little'))
+                if sys.byteorder != 'little':
+                    words.byteswap()
+                buffer.values[ordinals.start:ordinals.stop] = words.tolist()
+            elif width % 8 == 0:
+                octets = width // 8
+                data = value.to_bytes(size * octets, 'little')
+                pos = 0
+                for i in ordinals:
+                    n = sizes[i] * octets
+                    buffer.values[i] = int.from_bytes(data[pos:pos + n], 'little')
+                    pos += n
+            else:
+                for i in ordinals:
+                    n = sizes[i] * width
+                    buffer.values[i] = value & ((1 << n) - 1)
+                    value >>= n
+
+            # Loaded values replace any prior modifications.
+            if dirty:
+                for i in ordinals:
+                    buffer.bitmap[i >> 3] &= ~(1 << (i & 7)) & 0xff
+
+    def store_region(self, region, value):
+        self.write_region(region, value)
+        i = self.layout.ordinal(region)
+        self._store(i, self.buffer.values[i])
+
+    def sync(self):
+        # Only the modified registers need to be stored, which are visited in ordinal order.
+        buffer = self.buffer
+        ordinals = list(buffer.dirty())
+        if not ordinals:
+            return
+
+        if self.combine:
+            self._sync_combined(ordinals)
+        else:
+            self.llio.write_many(
+                [buffer.offsets[i] for i in ordinals],
+                [buffer.sizes[i] for i in ordinals],
+                [buffer.values[i] for i in ordinals])
+        buffer.clean()
+
+    def _sync_combined(self, ordinals):
+        # Merge registers that are adjacent in IO space (and of the same data width) into runs,
+        # which are written as multi-word accesses, so get split into the widest aligned stores. An
+        # ordered register ends the batch of runs before it (flushing them with a barrier) and is
+        # then stored on its own through the regular write path, followed by another barrier.
+        buffer = self.buffer
+        offsets = buffer.offsets
+        sizes = buffer.sizes
+        widths = self.layout.widths
+        ordered = self.layout.ordered
+        limit = self.COMBINE_BITS
+
+        runs = []
+        run_sizes = []
+        end = width = None
+        for i in ordinals:
+            offset = offsets[i]
+            if i in ordered:
+                runs.append(i)
+                run_sizes.append(sizes[i])
+                end = None
+                continue
+
+            size = sizes[i]
+            if offset == end and widths[i] == width and (run_sizes[-1] + size) * width <= limit:
+                runs[-1].append(i)
+                run_sizes[-1] += size
+            else:
+                runs.append([i])
+                run_sizes.append(size)
+                width = widths[i]
+            end = offset + size
+
+        batch = ([], [], [])
+        for run, size in zip(runs, run_sizes):
+            if isinstance(run, int):
+                if batch[0]:
+                    self.llio.write_combined(*batch)
+                    batch = ([], [], [])
+                self.llio.write_many((offsets[run],), (size,), (buffer.values[run],), barrier=True)
+                continue
+
+            batch[0].append(offsets[run[0]])
+            batch[1].append(size)
+            batch[2].append(self._run_value(run, size))
+
+        if batch[0]:
+            self.llio.write_combined(*batch)
+
+    def _run_value(self, run, size):
+        # Concatenate the values of a run's registers, with the lowest offset in the least
+        # significant bits. Runs of single word registers are packed as an array of words.
+        buffer = self.buffer
+        values = buffer.values
+        if len(run) == 1:
+            return values[run[0]]
+
+        width = self.layout.widths[run[0]]
+        fmt = RegisterLoadPlan.WORD_FORMATS.get(width)
+        if fmt is not None and size == len(run):
+            words = array.array(fmt, [values[i] for i in run])
+            if sys.byteorder != 'little':
+                words.byteswap()
+            return int.from_bytes(words.tobytes(), 'little')
+
+        value = shift = 0
+        for i in run:
+            n = buffer.sizes[i] * width
+            value |= (values[i] & ((1 << n) - 1)) << shift
+            shift += n
+        return value
+
 #---------------------------------------------------------------------------------------------------
 class ZeroIO(IO):
     def read(self, offset, size): return 0
@@ -1,6 +1,7 @@
 #---------------------------------------------------------------------------------------------------
 __all__ = ()
 
+import contextlib
 import mmap
 import os
 import pathlib
@@ -15,6 +16,9 @@ try:
 except ImportError:
     mmap_ext = None
 
+# The mmap module only exposes MAP_POPULATE from Python 3.10 onwards. Fall back to Linux's value.
+MAP_POPULATE = getattr(mmap, 'MAP_POPULATE', 0x8000)
+
 #---------------------------------------------------------------------------------------------------
 class MmapIO(io.IO):
     WORD_CTYPES = {
@@ -37,7 +41,8 @@ class MmapIO(io.IO):
     }
 
     def __init__(self, path, data_width,
-                 mmap_size=None, offset=0, endian=io.Endian.NATIVE,
+                 mmap_size=None, offset=0, endian=io.Endian.NATIVE, release_gil=True,
+                 write_combining=False, populate=False, cpus=None, absolute=False,
                  *pargs, **kargs):
         super().__init__(*pargs, **kargs)
 
@@ -61,7 +66,7 @@ class MmapIO(io.IO):
         if mmap_size is None:
             mmap_size = path.stat().st_size
 
-        self.page_no = (offset + mmap.PAGESIZE - 1) // mmap.PAGESIZE
+        self.page_no = offset // mmap.PAGESIZE
         self.page_offset = offset % mmap.PAGESIZE
         self.mmap_size = mmap_size - self.page_no * mmap.PAGESIZE
         self.libc = ffi.LibC()
@@ -76,27 +81,78 @@ class MmapIO(io.IO):
             self._bulk_ctype = self.WORD_CTYPES[psize][self.endian]
         else:
             self._bulk_ctype = self._word_ctype
+            psize = octets # Bulk accesses are single words (such as 64 bit words on 32 bit hosts).
 
         self.word_width = data_width
         self.word_mask = (1 << data_width) - 1
+        self.word_count = (self.mmap_size - self.page_offset) // octets
+
+        # Accesses are made by word offset from the start of the mapped region, or from the start of
+        # the file when absolute (such as when only the part of a file holding a spec's region is
+        # mapped). The origin is the offset of the first mapped word. Accessing words outside of the
+        # mapped range is invalid either way.
+        self.origin = offset // octets if absolute else 0
+        self._base_offset = self.page_offset - self.origin * octets
         self.bulk_width = psize * 8
         self.bulk_mask = (1 << self.bulk_width) - 1
         self.bulk_size = self.bulk_width // data_width
 
+        # Release the GIL around single word accesses (when supported), allowing other threads to
+        # run while waiting on slow reads. Batched and multi-word accesses always release the GIL.
+        self.release_gil = release_gil
+
+        # Prefetchable PCIe BARs can also be mapped with write combining through a sibling sysfs
+        # file (resourceN_wc for resourceN). When requested and available, the region is mapped a
+        # second time through it for combined writes, with all other accesses remaining uncached.
+        # Otherwise (or with indirect IO), combined writes fall back to using the uncached mapping.
+        wc_path = path.with_name(path.name + '_wc')
+        self.wc_path = wc_path if write_combining and wc_path.exists() else None
+
+        # Pre-fault the page tables of the whole mapping when starting, rather than taking a fault
+        # on the first access to each page.
+        self.populate = populate
+
+        # Set of CPUs local to the memory region (such as those of the NUMA node of a PCIe device),
+        # which threads accessing the IO can bind themselves to with bind_local_cpus.
+        self.cpus = None if cpus is None else frozenset(cpus)
+
+    def _map(self, path):
+        flags = mmap.MAP_SHARED
+        if self.populate:
+            flags |= MAP_POPULATE
+
+        with path.open('r+b') as fo:
+            return self.libc.mmap(
+                ffi.ctype.pointer.NULL, self.mmap_size, mmap.PROT_READ | mmap.PROT_WRITE,
+                flags, fo.fileno(), self.page_no * mmap.PAGESIZE)
+
     def start(self):
         if self.started:
             return
 
         # Map the file's memory region into the virtual address space.
-        with self.path.open('r+b') as fo:
-            self._addr_p = self.libc.mmap(
-                ffi.ctype.pointer.NULL, self.mmap_size, mmap.PROT_READ | mmap.PROT_WRITE,
-                mmap.MAP_SHARED, fo.fileno(), self.page_no * mmap.PAGESIZE)
+        self._addr_p = self._map(self.path)
 
-        # Set the base of the memory region's first word.
-        self._base_addr = self._addr_p.value + self.page_offset
+        # Set the base of the memory region's first word (relative to which offsets are given).
+        self._base_addr = self._addr_p.value + self._base_offset
         super().start()
 
+    # Zero-copy view over the words of the memory mapped region, starting from the word at the
+    # origin. The view has the native format for the word width when the region's endianness matches
+    # the host, otherwise it's a view of bytes.
+    # Note that copying from the view is done with memcpy semantics, which doesn't guarantee the
+    # width or count of the accesses issued. All views must be released prior to stopping.
+    BUFFER_FORMATS = {1: 'B', 2: 'H', 4: 'I', 8: 'Q'}
+
+    def buffer(self):
+        addr = self._addr_p.value + self.page_offset
+        nbytes = self.word_count * self.octets
+        view = memoryview(ffi.ctype.cast_to_array_pointer(
+            addr, ffi.ctype.integer.u8.le, nbytes).contents).cast('B')
+        if self.endian is not io.Endian.NATIVE.get():
+            return view
+        return view.cast(self.BUFFER_FORMATS[self.octets])
+
     def stop(self):
         if not self.started:
             return
@@ -107,6 +163,22 @@ class MmapIO(io.IO):
         del self._base_addr
         super().stop()
 
+    # Bind the calling thread to the local CPUs (if any) for the duration of the context, restoring
+    # its previous affinity on exit. Only the calling thread is affected, so each thread accessing
+    # the IO must bind itself. Contexts of different IOs may be nested, with the innermost winning.
+    @contextlib.contextmanager
+    def bind_local_cpus(self):
+        if self.cpus is None:
+            yield
+            return
+
+        saved = os.sched_getaffinity(0)
+        os.sched_setaffinity(0, self.cpus)
+        try:
+            yield
+        finally:
+            os.sched_setaffinity(0, saved)
+
 #---------------------------------------------------------------------------------------------------
 class MmapIndirectIO(MmapIO):
     def start(self):
@@ -131,7 +203,7 @@ class MmapIndirectIO(MmapIO):
 
         # Multi word access. Split the access to minimize operations while respecting alignment.
         ops = []
-        count = offset % self.bulk_size
+        count = -offset % self.bulk_size
         if count != 0:
             ops.append((self._word_ptr, offset, count, self.word_width, self.word_mask))
             offset += count
@@ -157,6 +229,7 @@ class MmapIndirectIO(MmapIO):
             while count > 0:
                 value |= (ptr[offset].value & mask) << shift
                 shift += width
+                offset += 1
                 count -= 1
         return value
 
@@ -165,6 +238,7 @@ class MmapIndirectIO(MmapIO):
             while count > 0:
                 ptr[offset].value = value & mask
                 value >>= width
+                offset += 1
                 count -= 1
 
     def update(self, offset, size, clr_mask, set_mask):
@@ -178,6 +252,7 @@ class MmapIndirectIO(MmapIO):
 
                 clr_mask >>= width
                 set_mask >>= width
+                offset += 1
                 count -= 1
 
 #---------------------------------------------------------------------------------------------------
@@ -196,29 +271,87 @@ else:
                 super().start()
 
                 # Instantiate a direct IO object from the C extension.
-                self._direct_io = mmap_ext.MmapDirectIO(
-                    self._base_addr, self.word_width, self.bulk_width,
-                    self.endian == io.Endian.LITTLE)
+                self._direct_io = self._new_direct_io(self._base_addr)
+
+                # Buffers are exported from the first mapped word, which is only the base of the
+                # word offsets when they're relative to the start of the mapping.
+                self._buffer_io = self._direct_io
+                if self.origin != 0:
+                    self._buffer_io = self._new_direct_io(self._addr_p.value + self.page_offset)
+
+                # Setup the write combining mapping, if any.
+                self._wc_io = self._direct_io
+                if self.wc_path is not None:
+                    self._wc_addr_p = self._map(self.wc_path)
+                    self._wc_io = self._new_direct_io(self._wc_addr_p.value + self._base_offset)
+
+        def _new_direct_io(self, base_addr):
+            return mmap_ext.MmapDirectIO(
+                base_addr, self.word_width, self.bulk_width,
+                self.endian == io.Endian.LITTLE, self.word_count, self.release_gil)
 
         def stop(self):
             if self.started:
+                # Unmapping the region would leave any exported buffers dangling.
+                if self._direct_io.exports > 0 or self._buffer_io.exports > 0:
+                    raise BufferError(f'Cannot stop {self.path} while buffers are exported.')
+
+                # Nor can the region be unmapped while other threads are accessing it.
+                if self._direct_io.accesses > 0 or self._wc_io.accesses > 0:
+                    raise BufferError(f'Cannot stop {self.path} while accesses are in progress.')
+
+                wc_mapped = self._wc_io is not self._direct_io
+                del self._wc_io
+                del self._buffer_io
                 del self._direct_io
+                if wc_mapped:
+                    self.libc.munmap(self._wc_addr_p, self.mmap_size)
+                    del self._wc_addr_p
                 super().stop()
 
+        def buffer(self):
+            return memoryview(self._buffer_io)
+
         def read(self, offset, size):
             return self._direct_io.read(offset, size)
 
+        def read_many(self, offsets, sizes, out=None):
+            return self._direct_io.read_many(offsets, sizes, out)
+
         def write(self, offset, size, value):
             self._direct_io.write(offset, size, value)
 
         def update(self, offset, size, clr_mask, set_mask):
             self._direct_io.update(offset, size, clr_mask, set_mask)
 
+        def write_many(self, offsets, sizes, values, barrier=False):
+            self._direct_io.write_many(offsets, sizes, values, barrier)
+
+        def update_many(self, offsets, sizes, clr_masks, set_masks, barrier=False):
+            self._direct_io.update_many(offsets, sizes, clr_masks, set_masks, barrier)
+
+        def write_combined(self, offsets, sizes, values):
+            self._wc_io.write_many(offsets, sizes, values, True)
+
+        def poll_until(self, offset, size, mask, value, timeout=None, backoff=1e-3):
+            # Accesses wider than 64 bits are polled from Python instead.
+            if size * self.word_width > 64:
+                return super().poll_until(offset, size, mask, value, timeout, backoff)
+            return self._direct_io.poll_until(offset, size, mask, value, timeout, backoff)
+
 #---------------------------------------------------------------------------------------------------
 class DevMmapIO(MmapDirectIO): ...
 class DevMmapIOForSpec(DevMmapIO):
-    def __init__(self, spec, path, *pargs, **kargs):
-        super().__init__(path, info.data_width_of(spec), *pargs, **kargs)
+    # Only the pages of the device file holding the spec's region are mapped, rather than the whole
+    # file. PCIe BARs can be far larger than the registers they contain, and mapping them in full
+    # wastes page table memory. Accesses are still made by the absolute offsets of the registers.
+    def __init__(self, spec, path, *pargs, mmap_size=None, **kargs):
+        if mmap_size is None:
+            region = info.region_of(spec)
+            start = region.offset.absolute * (region.data_width // 8)
+            mmap_size = min(start + region.octets, pathlib.Path(path).stat().st_size)
+            kargs.update(offset=start, absolute=True)
+        super().__init__(path, info.data_width_of(spec), *pargs, mmap_size=mmap_size, **kargs)
 
 #---------------------------------------------------------------------------------------------------
 class FileMmapIO(MmapDirectIO):
@@ -5,6 +5,8 @@
 #include <endian.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <string.h>
+#include <time.h>
 
 /* Defined to simplify read/write/update macros below. */
 #define htobe8(_x) ((uint8_t)(_x))
@@ -13,7 +15,7 @@
 #define le8toh(_x) ((uint8_t)(_x))
 
 /*
- * Notes for implementing multi-word support:
+ * Notes on multi-word support:
  * - The int_from_bytes_impl function implements the int.from_bytes method.
  *   - https://github.com/python/cpython/blob/main/Objects/longobject.c#L6102
  * - The _PyLong_FromByteArray function does the conversion from an array of bytes to a Python int
@@ -23,9 +25,19 @@
  *   - https://github.com/python/cpython/blob/main/Objects/longobject.c#L6040
  * - The _PyLong_AsByteArray function does the conversion from a Python int to an array of bytes.
  *   - https://github.com/python/cpython/blob/main/Objects/longobject.c#L929
- * - Look into using the buffer protocol in conjunction with array.array() for passing multi-word
- *   blocks between Python and C.
+ *   - Python 3.13 added a trailing with_exceptions argument.
  */
+#if PY_VERSION_HEX >= 0x030D0000
+#define _long_as_bytes(_v, _bytes, _n, _is_signed) \
+    _PyLong_AsByteArray((PyLongObject*)(_v), (_bytes), (_n), 1, (_is_signed), 1)
+#else
+#define _long_as_bytes(_v, _bytes, _n, _is_signed) \
+    _PyLong_AsByteArray((PyLongObject*)(_v), (_bytes), (_n), 1, (_is_signed))
+#endif
+#define _long_from_bytes(_bytes, _n) _PyLong_FromByteArray((_bytes), (_n), 1, 0)
+
+/* Size in bytes of the on-stack buffer used for multi-word conversions (covers up to 512 bits). */
+#define MMAP_DIRECT_IO_STACK_BYTES 64
 
 /*------------------------------------------------------------------------------------------------*/
 typedef struct {
@@ -36,8 +48,34 @@ typedef struct {
     unsigned int bulk_width;
     unsigned int bulk_size;
     bool little_endian;
+    bool release_gil;
+    Py_ssize_t size;
+    Py_ssize_t exports;
+    Py_ssize_t accesses;
 }  MmapDirectIO;
 
+/*
+ * Thread safety: The GIL is released around the accesses to the memory mapped region, such that
+ * threads accessing other regions (or doing anything else) aren't held up by slow non-posted reads.
+ * Batches of accesses of up to 64 bits each release it once for the whole batch, after all
+ * arguments have been converted, while accesses wider than 64 bits release it for each access.
+ * Single accesses of up to 64 bits only release it when release_gil is set, since the cost of
+ * releasing and re-acquiring the GIL can exceed that of the access itself for RAM backed regions.
+ *
+ * An object can be shared between threads, but no ordering is implied between accesses made by
+ * different threads, including the read-modify-writes done by updates. The count of accesses in
+ * progress guards against the object being re-initialized (and lets the owner of the mapping refuse
+ * to unmap it) while any thread is accessing the region without holding the GIL.
+ */
+#define _begin_access(_self) { \
+    ++((MmapDirectIO*)(_self))->accesses; \
+    Py_BEGIN_ALLOW_THREADS
+
+#define _end_access(_self) \
+    Py_END_ALLOW_THREADS \
+    --((MmapDirectIO*)(_self))->accesses; \
+}
+
 /*------------------------------------------------------------------------------------------------*/
 static PyObject* MmapDirectIO_new(
     PyTypeObject* type, PyObject* Py_UNUSED(pargs), PyObject* Py_UNUSED(kargs)) {
@@ -68,19 +106,38 @@ static int MmapDirectIO_init(PyObject* _self, PyObject* pargs, PyObject* kargs)
         "word_width",
         "bulk_width",
         "little_endian",
+        "size",
+        "release_gil",
         NULL
     };
 
     MmapDirectIO* self = (typeof(self))_self;
     int little_endian = 0;
+    int release_gil = 1;
 
+    if (self->exports > 0) {
+        PyErr_SetString(PyExc_BufferError, "Cannot re-initialize while buffers are exported");
+        return -1;
+    }
+
+    if (self->accesses > 0) {
+        PyErr_SetString(PyExc_BufferError, "Cannot re-initialize while accesses are in progress");
+        return -1;
+    }
+
+    self->size = 0;
     int rv = PyArg_ParseTupleAndKeywords(
-        pargs, kargs, "KIIp", kargs_list,
+        pargs, kargs, "KIIp|np", kargs_list,
         &self->base_addr, &self->word_width,
-        &self->bulk_width, &little_endian);
+        &self->bulk_width, &little_endian, &self->size, &release_gil);
     if (rv == 0)
         return -1;
 
+    if (self->size < 0) {
+        PyErr_Format(PyExc_ValueError, "Invalid negative size %zd", self->size);
+        return -1;
+    }
+
     if (!MmapDirectIO_is_valid_data_width(self->word_width)) {
         PyErr_Format(PyExc_ValueError, "Invalid word data width %u", self->word_width);
         return -1;
@@ -91,8 +148,17 @@ static int MmapDirectIO_init(PyObject* _self, PyObject* pargs, PyObject* kargs)
         return -1;
     }
 
+    /* Bulk accesses are made of whole words, so can't be narrower than them. */
+    if (self->bulk_width < self->word_width) {
+        PyErr_Format(
+            PyExc_ValueError, "Bulk data width %u is narrower than word data width %u",
+            self->bulk_width, self->word_width);
+        return -1;
+    }
+
     self->bulk_size = self->bulk_width / self->word_width;
     self->little_endian = little_endian != 0;
+    self->release_gil = release_gil != 0;
 
     return 0;
 }
@@ -105,7 +171,6 @@ static PyObject* MmapDirectIO_repr(PyObject *_self) {
         "%s(%p, %u, %u, %R)", Py_TYPE(self)->tp_name, self->base_addr,
         self->word_width, self->bulk_width, self->little_endian ? Py_True : Py_False);
 }
-
 /*------------------------------------------------------------------------------------------------*/
 #define __ptr_read(_width, _self, _offset, _value) { \
     uint##_width##_t __tmp = ((volatile typeof(__tmp)*)((_self)->base_addr))[(_offset)]; \
@@ -116,14 +181,226 @@ static PyObject* MmapDirectIO_repr(PyObject *_self) {
 #define _ptr_read(_width, _self, _offset, _value) \
     __ptr_read(_width, _self, _offset, _value)
 
-static PyObject* MmapDirectIO_read(PyObject* _self, PyObject* args) {
-    MmapDirectIO* self = (typeof(self))_self;
-    unsigned long long offset;
-    unsigned long long size;
-    unsigned long long value;
+#define __ptr_write(_width, _self, _offset, _value) { \
+    uint##_width##_t __tmp = (typeof(__tmp))(_value); \
+    __tmp = (_self)->little_endian ? htole##_width(__tmp) : htobe##_width(__tmp); \
+    ((volatile typeof(__tmp)*)((_self)->base_addr))[(_offset)] = __tmp; \
+}
 
-    if (!PyArg_ParseTuple(args, "KK", &offset, &size))
+#define _ptr_write(_width, _self, _offset, _value) \
+    __ptr_write(_width, _self, _offset, _value)
+
+#define __ptr_update(_width, _self, _offset, _clr_mask, _set_mask) {\
+    uint##_width##_t __tmp = ((volatile typeof(__tmp)*)((_self)->base_addr))[(_offset)]; \
+    __tmp = (_self)->little_endian ? le##_width##toh(__tmp) : be##_width##toh(__tmp); \
+    __tmp &= (typeof(__tmp))(_clr_mask); \
+    __tmp |= (typeof(__tmp))(_set_mask); \
+    __tmp = (_self)->little_endian ? htole##_width(__tmp) : htobe##_width(__tmp); \
+    ((volatile typeof(__tmp)*)((_self)->base_addr))[(_offset)] = __tmp; \
+}
+
+#define _ptr_update(_width, _self, _offset, _clr_mask, _set_mask) \
+    __ptr_update(_width, _self, _offset, _clr_mask, _set_mask)
+
+/*------------------------------------------------------------------------------------------------*/
+/*
+ * A multi-word access is split into a sequence of operations, each one covering a run of words
+ * accessed with the same width. The words are exchanged with Python as an array of bytes in
+ * little endian order, such that the word at the lowest offset holds the least significant bits.
+ */
+typedef struct {
+    unsigned int width;
+    unsigned long long offset; /* In units of width. */
+    unsigned long long count;
+} MmapDirectIO_Op;
+
+#define MMAP_DIRECT_IO_MAX_OPS 3
+
+/* Split the access to minimize operations while respecting alignment. */
+static unsigned int MmapDirectIO_operations(
+    const MmapDirectIO* self, unsigned long long offset, unsigned long long size,
+    MmapDirectIO_Op* ops) {
+    unsigned long long bulk_size = self->bulk_size;
+    unsigned long long count;
+    unsigned int nops = 0;
+
+    /* Single word access. */
+    if (size < bulk_size) {
+        ops[nops++] = (MmapDirectIO_Op){self->word_width, offset, size};
+        return nops;
+    }
+
+    /* Leading words up to the first bulk boundary. */
+    count = (bulk_size - offset % bulk_size) % bulk_size;
+    if (count != 0) {
+        ops[nops++] = (MmapDirectIO_Op){self->word_width, offset, count};
+        offset += count;
+        size -= count;
+    }
+
+    /* Bulk words. */
+    if (size >= bulk_size) {
+        count = size / bulk_size;
+        ops[nops++] = (MmapDirectIO_Op){self->bulk_width, offset / bulk_size, count};
+
+        count *= bulk_size;
+        offset += count;
+        size -= count;
+    }
+
+    /* Trailing words after the last bulk boundary. */
+    if (size > 0)
+        ops[nops++] = (MmapDirectIO_Op){self->word_width, offset, size};
+    return nops;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+#define _ops_read(_width, _self, _op, _bytes) { \
+    for (unsigned long long __i = 0; __i < (_op)->count; ++__i) { \
+        uint##_width##_t __word; \
+        _ptr_read(_width, _self, (_op)->offset + __i, __word); \
+        __word = htole##_width(__word); \
+        memcpy((_bytes), &__word, sizeof(__word)); \
+        (_bytes) += sizeof(__word); \
+    } \
+}
+
+static void MmapDirectIO_ops_read(
+    const MmapDirectIO* self, const MmapDirectIO_Op* ops, unsigned int nops, unsigned char* bytes) {
+    for (const MmapDirectIO_Op* op = ops; op < ops + nops; ++op) {
+        switch (op->width) {
+        case 8: _ops_read(8, self, op, bytes); break;
+        case 16: _ops_read(16, self, op, bytes); break;
+        case 32: _ops_read(32, self, op, bytes); break;
+        case 64: _ops_read(64, self, op, bytes); break;
+        default: break; /* Widths are validated during init and are read-only. */
+        }
+    }
+}
+
+#define _ops_write(_width, _self, _op, _bytes) { \
+    for (unsigned long long __i = 0; __i < (_op)->count; ++__i) { \
+        uint##_width##_t __word; \
+        memcpy(&__word, (_bytes), sizeof(__word)); \
+        (_bytes) += sizeof(__word); \
+        __word = le##_width##toh(__word); \
+        _ptr_write(_width, _self, (_op)->offset + __i, __word); \
+    } \
+}
+
+static void MmapDirectIO_ops_write(
+    const MmapDirectIO* self, const MmapDirectIO_Op* ops, unsigned int nops,
+    const unsigned char* bytes) {
+    for (const MmapDirectIO_Op* op = ops; op < ops + nops; ++op) {
+        switch (op->width) {
+        case 8: _ops_write(8, self, op, bytes); break;
+        case 16: _ops_write(16, self, op, bytes); break;
+        case 32: _ops_write(32, self, op, bytes); break;
+        case 64: _ops_write(64, self, op, bytes); break;
+        default: break; /* Widths are validated during init and are read-only. */
+        }
+    }
+}
+
+#define _ops_update(_width, _self, _op, _clr_bytes, _set_bytes) { \
+    for (unsigned long long __i = 0; __i < (_op)->count; ++__i) { \
+        uint##_width##_t __clr_mask; \
+        uint##_width##_t __set_mask; \
+        memcpy(&__clr_mask, (_clr_bytes), sizeof(__clr_mask)); \
+        memcpy(&__set_mask, (_set_bytes), sizeof(__set_mask)); \
+        (_clr_bytes) += sizeof(__clr_mask); \
+        (_set_bytes) += sizeof(__set_mask); \
+        __clr_mask = le##_width##toh(__clr_mask); \
+        __set_mask = le##_width##toh(__set_mask); \
+        _ptr_update(_width, _self, (_op)->offset + __i, __clr_mask, __set_mask); \
+    } \
+}
+
+static void MmapDirectIO_ops_update(
+    const MmapDirectIO* self, const MmapDirectIO_Op* ops, unsigned int nops,
+    const unsigned char* clr_bytes, const unsigned char* set_bytes) {
+    for (const MmapDirectIO_Op* op = ops; op < ops + nops; ++op) {
+        switch (op->width) {
+        case 8: _ops_update(8, self, op, clr_bytes, set_bytes); break;
+        case 16: _ops_update(16, self, op, clr_bytes, set_bytes); break;
+        case 32: _ops_update(32, self, op, clr_bytes, set_bytes); break;
+        case 64: _ops_update(64, self, op, clr_bytes, set_bytes); break;
+        default: break; /* Widths are validated during init and are read-only. */
+        }
+    }
+}
+
+/*------------------------------------------------------------------------------------------------*/
+/* Allocate a buffer for converting nbufs multi-word values of size words each. */
+static unsigned char* MmapDirectIO_bytes_alloc(
+    const MmapDirectIO* self, unsigned long long size, size_t nbufs,
+    unsigned char* stack, size_t* nbytes) {
+    size_t octets = self->word_width / 8;
+
+    if (size > PY_SSIZE_T_MAX / octets / nbufs) {
+        PyErr_Format(PyExc_OverflowError, "Access size of %llu words is too large", size);
         return NULL;
+    }
+
+    *nbytes = size * octets;
+    if (*nbytes * nbufs <= MMAP_DIRECT_IO_STACK_BYTES)
+        return stack;
+
+    unsigned char* bytes = PyMem_Malloc(*nbytes * nbufs);
+    if (bytes == NULL)
+        PyErr_NoMemory();
+    return bytes;
+}
+
+static void MmapDirectIO_bytes_free(unsigned char* bytes, unsigned char* stack) {
+    if (bytes != stack)
+        PyMem_Free(bytes);
+}
+
+/*
+ * Convert a Python int to nbytes in little endian order. Negative values (such as the inverted
+ * masks used for updates) are converted using two's complement and values too large to fit are
+ * truncated, matching the behaviour of the single word accesses.
+ */
+static int MmapDirectIO_long_as_bytes(PyObject* value, unsigned char* bytes, size_t nbytes) {
+    PyObject* index = PyNumber_Index(value);
+    if (index == NULL)
+        return -1;
+
+    int rv = _long_as_bytes(index, bytes, nbytes, 0);
+    if (rv < 0 && PyErr_ExceptionMatches(PyExc_OverflowError)) {
+        PyErr_Clear();
+        rv = _long_as_bytes(index, bytes, nbytes, 1);
+    }
+
+    if (rv < 0 && PyErr_ExceptionMatches(PyExc_OverflowError)) {
+        PyErr_Clear();
+
+        /* Truncate the value by masking it down to the number of bits available. */
+        PyObject* one = PyLong_FromLong(1);
+        PyObject* nbits = PyLong_FromSize_t(nbytes * 8);
+        PyObject* limit = one != NULL && nbits != NULL ? PyNumber_Lshift(one, nbits) : NULL;
+        PyObject* mask = limit != NULL ? PyNumber_Subtract(limit, one) : NULL;
+        PyObject* masked = mask != NULL ? PyNumber_And(index, mask) : NULL;
+
+        rv = masked != NULL ? _long_as_bytes(masked, bytes, nbytes, 0) : -1;
+
+        Py_XDECREF(masked);
+        Py_XDECREF(mask);
+        Py_XDECREF(limit);
+        Py_XDECREF(nbits);
+        Py_XDECREF(one);
+    }
+
+    Py_DECREF(index);
+    return rv;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+/* Read an access of up to 64 bits. */
+static unsigned long long MmapDirectIO_read_ull(
+    const MmapDirectIO* self, unsigned long long offset, unsigned long long size) {
+    unsigned long long value = 0;
 
     /* Handle fast path accesses. */
     if (size == 1) {
@@ -132,49 +409,48 @@ static PyObject* MmapDirectIO_read(PyObject* _self, PyObject* args) {
         case 16: _ptr_read(16, self, offset, value); break;
         case 32: _ptr_read(32, self, offset, value); break;
         case 64: _ptr_read(64, self, offset, value); break;
-        default: value = 0; break; /* word_width is validated during init and is read-only. */
+        default: break; /* word_width is validated during init and is read-only. */
         }
-        return PyLong_FromLongLong(value);
+        return value;
     }
 
-    if (size == self->bulk_size) {
+    if (size == self->bulk_size && offset % self->bulk_size == 0) {
         offset /= self->bulk_size;
         switch (self->bulk_width) {
         case 8: _ptr_read(8, self, offset, value); break;
         case 16: _ptr_read(16, self, offset, value); break;
         case 32: _ptr_read(32, self, offset, value); break;
         case 64: _ptr_read(64, self, offset, value); break;
-        default: value = 0; break; /* bulk_width is validated during init and is read-only. */
+        default: break; /* bulk_width is validated during init and is read-only. */
         }
-        return PyLong_FromLongLong(value);
+        return value;
     }
 
-    /* TODO: Fill in slow path for multi-word accesses. See notes at top of file. */
+    /* Handle slow path for multi-word and unaligned bulk accesses. */
+    MmapDirectIO_Op ops[MMAP_DIRECT_IO_MAX_OPS];
+    unsigned char bytes[sizeof(uint64_t)] = {0};
+    unsigned int nops = MmapDirectIO_operations(self, offset, size, ops);
+    MmapDirectIO_ops_read(self, ops, nops, bytes);
 
-    PyErr_Format(PyExc_ValueError, "Invalid read size of %u from offset 0x%08x", size, offset);
-    return NULL;
+    uint64_t word;
+    memcpy(&word, bytes, sizeof(word));
+    return le64toh(word);
 }
 
 /*------------------------------------------------------------------------------------------------*/
-#define __ptr_write(_width, _self, _offset, _value) { \
-    uint##_width##_t __tmp = (typeof(__tmp))(_value); \
-    __tmp = (_self)->little_endian ? htole##_width(__tmp) : htobe##_width(__tmp); \
-    ((volatile typeof(__tmp)*)((_self)->base_addr))[(_offset)] = __tmp; \
-}
-
-#define _ptr_write(_width, _self, _offset, _value) \
-    __ptr_write(_width, _self, _offset, _value)
-
-static PyObject* MmapDirectIO_write(PyObject* _self, PyObject* args) {
-    MmapDirectIO* self = (typeof(self))_self;
-    unsigned long long offset;
-    unsigned long long size;
-    unsigned long long value; //PyObject* value;
-
-    //if (!PyArg_ParseTuple(args, "KKO", &offset, &size, &value))
-    if (!PyArg_ParseTuple(args, "KKK", &offset, &size, &value))
-        return NULL;
+/* Order all preceeding stores to the memory mapped region before any subsequent ones. */
+#if defined(__x86_64__) || defined(__i386__)
+#define _store_barrier() __asm__ __volatile__("sfence" ::: "memory")
+#elif defined(__aarch64__)
+#define _store_barrier() __asm__ __volatile__("dmb oshst" ::: "memory")
+#else
+#define _store_barrier() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#endif
 
+/* Write/update an access of up to 64 bits. */
+static void MmapDirectIO_write_ull(
+    const MmapDirectIO* self, unsigned long long offset, unsigned long long size,
+    unsigned long long value) {
     /* Handle fast path accesses. */
     if (size == 1) {
         switch (self->word_width) {
@@ -184,10 +460,10 @@ static PyObject* MmapDirectIO_write(PyObject* _self, PyObject* args) {
         case 64: _ptr_write(64, self, offset, value); break;
         default: break; /* word_width is validated during init and is read-only. */
         }
-        Py_RETURN_NONE;
+        return;
     }
 
-    if (size == self->bulk_size) {
+    if (size == self->bulk_size && offset % self->bulk_size == 0) {
         offset /= self->bulk_size;
         switch (self->bulk_width) {
         case 8: _ptr_write(8, self, offset, value); break;
@@ -196,39 +472,19 @@ static PyObject* MmapDirectIO_write(PyObject* _self, PyObject* args) {
         case 64: _ptr_write(64, self, offset, value); break;
         default: break; /* bulk_width is validated during init and is read-only. */
         }
-        Py_RETURN_NONE;
+        return;
     }
 
-    /* TODO: Fill in slow path for multi-word accesses. See notes at top of file. */
-
-    PyErr_Format(PyExc_ValueError, "Invalid write size of %u to offset 0x%08x", size, offset);
-    Py_RETURN_NONE;
+    /* Handle slow path for multi-word and unaligned bulk accesses. */
+    MmapDirectIO_Op ops[MMAP_DIRECT_IO_MAX_OPS];
+    uint64_t word = htole64(value);
+    unsigned int nops = MmapDirectIO_operations(self, offset, size, ops);
+    MmapDirectIO_ops_write(self, ops, nops, (const unsigned char*)&word);
 }
 
-/*------------------------------------------------------------------------------------------------*/
-#define __ptr_update(_width, _self, _offset, _clr_mask, _set_mask) {\
-    uint##_width##_t __tmp = ((volatile typeof(__tmp)*)((_self)->base_addr))[(_offset)]; \
-    __tmp = (_self)->little_endian ? le##_width##toh(__tmp) : be##_width##toh(__tmp); \
-    __tmp &= (typeof(__tmp))(_clr_mask); \
-    __tmp |= (typeof(__tmp))(_set_mask); \
-    __tmp = (_self)->little_endian ? htole##_width(__tmp) : htobe##_width(__tmp); \
-    ((volatile typeof(__tmp)*)((_self)->base_addr))[(_offset)] = __tmp; \
-}
-
-#define _ptr_update(_width, _self, _offset, _clr_mask, _set_mask) \
-    __ptr_update(_width, _self, _offset, _clr_mask, _set_mask)
-
-static PyObject* MmapDirectIO_update(PyObject* _self, PyObject* args) {
-    MmapDirectIO* self = (typeof(self))_self;
-    unsigned long long offset;
-    unsigned long long size;
-    unsigned long long clr_mask; //PyObject* clr_mask;
-    unsigned long long set_mask; //PyObject* set_mask;
-
-    //if (!PyArg_ParseTuple(args, "KKOO", &offset, &size, &clr_mask, &set_mask))
-    if (!PyArg_ParseTuple(args, "KKKK", &offset, &size, &clr_mask, &set_mask))
-        return NULL;
-
+static void MmapDirectIO_update_ull(
+    const MmapDirectIO* self, unsigned long long offset, unsigned long long size,
+    unsigned long long clr_mask, unsigned long long set_mask) {
     /* Handle fast path accesses. */
     if (size == 1) {
         switch (self->word_width) {
@@ -238,10 +494,10 @@ static PyObject* MmapDirectIO_update(PyObject* _self, PyObject* args) {
         case 64: _ptr_update(64, self, offset, clr_mask, set_mask); break;
         default: break; /* word_width is validated during init and is read-only. */
         }
-        Py_RETURN_NONE;
+        return;
     }
 
-    if (size == self->bulk_size) {
+    if (size == self->bulk_size && offset % self->bulk_size == 0) {
         offset /= self->bulk_size;
         switch (self->bulk_width) {
         case 8: _ptr_update(8, self, offset, clr_mask, set_mask); break;
@@ -250,15 +506,950 @@ static PyObject* MmapDirectIO_update(PyObject* _self, PyObject* args) {
         case 64: _ptr_update(64, self, offset, clr_mask, set_mask); break;
         default: break; /* bulk_width is validated during init and is read-only. */
         }
+        return;
+    }
+
+    /* Handle slow path for multi-word and unaligned bulk accesses. */
+    MmapDirectIO_Op ops[MMAP_DIRECT_IO_MAX_OPS];
+    uint64_t clr_word = htole64(clr_mask);
+    uint64_t set_word = htole64(set_mask);
+    unsigned int nops = MmapDirectIO_operations(self, offset, size, ops);
+    MmapDirectIO_ops_update(
+        self, ops, nops, (const unsigned char*)&clr_word, (const unsigned char*)&set_word);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+static PyObject* MmapDirectIO_read_multi(
+    const MmapDirectIO* self, unsigned long long offset, unsigned long long size) {
+    MmapDirectIO_Op ops[MMAP_DIRECT_IO_MAX_OPS];
+    unsigned char stack[MMAP_DIRECT_IO_STACK_BYTES];
+    size_t nbytes;
+
+    unsigned char* bytes = MmapDirectIO_bytes_alloc(self, size, 1, stack, &nbytes);
+    if (bytes == NULL)
+        return NULL;
+
+    unsigned int nops = MmapDirectIO_operations(self, offset, size, ops);
+    _begin_access(self);
+    MmapDirectIO_ops_read(self, ops, nops, bytes);
+    _end_access(self);
+
+    PyObject* value = _long_from_bytes(bytes, nbytes);
+    MmapDirectIO_bytes_free(bytes, stack);
+    return value;
+}
+
+static PyObject* MmapDirectIO_read(PyObject* _self, PyObject* args) {
+    MmapDirectIO* self = (typeof(self))_self;
+    unsigned long long offset;
+    unsigned long long size;
+    unsigned long long value;
+
+    if (!PyArg_ParseTuple(args, "KK", &offset, &size))
+        return NULL;
+
+    /* Handle fast path accesses. */
+    if (size <= 64 / self->word_width) {
+        if (self->release_gil) {
+            _begin_access(self);
+            value = MmapDirectIO_read_ull(self, offset, size);
+            _end_access(self);
+        } else {
+            value = MmapDirectIO_read_ull(self, offset, size);
+        }
+        return PyLong_FromUnsignedLongLong(value);
+    }
+
+    /* Handle slow path for multi-word accesses. */
+    return MmapDirectIO_read_multi(self, offset, size);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+static PyObject* MmapDirectIO_write_multi(
+    const MmapDirectIO* self, unsigned long long offset, unsigned long long size,
+    PyObject* value) {
+    MmapDirectIO_Op ops[MMAP_DIRECT_IO_MAX_OPS];
+    unsigned char stack[MMAP_DIRECT_IO_STACK_BYTES];
+    size_t nbytes;
+
+    unsigned char* bytes = MmapDirectIO_bytes_alloc(self, size, 1, stack, &nbytes);
+    if (bytes == NULL)
+        return NULL;
+
+    if (MmapDirectIO_long_as_bytes(value, bytes, nbytes) < 0) {
+        MmapDirectIO_bytes_free(bytes, stack);
+        return NULL;
+    }
+
+    unsigned int nops = MmapDirectIO_operations(self, offset, size, ops);
+    _begin_access(self);
+    MmapDirectIO_ops_write(self, ops, nops, bytes);
+    _end_access(self);
+
+    MmapDirectIO_bytes_free(bytes, stack);
+    Py_RETURN_NONE;
+}
+
+static PyObject* MmapDirectIO_write(PyObject* _self, PyObject* args) {
+    MmapDirectIO* self = (typeof(self))_self;
+    unsigned long long offset;
+    unsigned long long size;
+    PyObject* value;
+
+    if (!PyArg_ParseTuple(args, "KKO", &offset, &size, &value))
+        return NULL;
+
+    /* Handle fast path accesses. */
+    if (size <= 64 / self->word_width) {
+        unsigned long long v = PyLong_AsUnsignedLongLongMask(value);
+        if (v == (unsigned long long)-1 && PyErr_Occurred())
+            return NULL;
+
+        if (self->release_gil) {
+            _begin_access(self);
+            MmapDirectIO_write_ull(self, offset, size, v);
+            _end_access(self);
+        } else {
+            MmapDirectIO_write_ull(self, offset, size, v);
+        }
         Py_RETURN_NONE;
     }
 
-    /* TODO: Fill in slow path for multi-word accesses. See notes at top of file. */
+    /* Handle slow path for multi-word accesses. */
+    return MmapDirectIO_write_multi(self, offset, size, value);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+static PyObject* MmapDirectIO_update_multi(
+    const MmapDirectIO* self, unsigned long long offset, unsigned long long size,
+    PyObject* clr_mask, PyObject* set_mask) {
+    MmapDirectIO_Op ops[MMAP_DIRECT_IO_MAX_OPS];
+    unsigned char stack[MMAP_DIRECT_IO_STACK_BYTES];
+    size_t nbytes;
+
+    unsigned char* bytes = MmapDirectIO_bytes_alloc(self, size, 2, stack, &nbytes);
+    if (bytes == NULL)
+        return NULL;
+
+    unsigned char* clr_bytes = bytes;
+    unsigned char* set_bytes = bytes + nbytes;
+    if (MmapDirectIO_long_as_bytes(clr_mask, clr_bytes, nbytes) < 0 ||
+        MmapDirectIO_long_as_bytes(set_mask, set_bytes, nbytes) < 0) {
+        MmapDirectIO_bytes_free(bytes, stack);
+        return NULL;
+    }
+
+    unsigned int nops = MmapDirectIO_operations(self, offset, size, ops);
+    _begin_access(self);
+    MmapDirectIO_ops_update(self, ops, nops, clr_bytes, set_bytes);
+    _end_access(self);
 
-    PyErr_Format(PyExc_ValueError, "Invalid update size of %u at offset 0x%08x", size, offset);
+    MmapDirectIO_bytes_free(bytes, stack);
     Py_RETURN_NONE;
 }
 
+static PyObject* MmapDirectIO_update(PyObject* _self, PyObject* args) {
+    MmapDirectIO* self = (typeof(self))_self;
+    unsigned long long offset;
+    unsigned long long size;
+    PyObject* clr_mask;
+    PyObject* set_mask;
+
+    if (!PyArg_ParseTuple(args, "KKOO", &offset, &size, &clr_mask, &set_mask))
+        return NULL;
+
+    /* Handle fast path accesses. */
+    if (size <= 64 / self->word_width) {
+        unsigned long long clr = PyLong_AsUnsignedLongLongMask(clr_mask);
+        if (clr == (unsigned long long)-1 && PyErr_Occurred())
+            return NULL;
+
+        unsigned long long set = PyLong_AsUnsignedLongLongMask(set_mask);
+        if (set == (unsigned long long)-1 && PyErr_Occurred())
+            return NULL;
+
+        if (self->release_gil) {
+            _begin_access(self);
+            MmapDirectIO_update_ull(self, offset, size, clr, set);
+            _end_access(self);
+        } else {
+            MmapDirectIO_update_ull(self, offset, size, clr, set);
+        }
+        Py_RETURN_NONE;
+    }
+
+    /* Handle slow path for multi-word accesses. */
+    return MmapDirectIO_update_multi(self, offset, size, clr_mask, set_mask);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+/*
+ * Batched accesses take their offsets and sizes (and values or masks for writes/updates) as
+ * parallel vectors. A vector can be given as a sequence of ints or as an object supporting the
+ * buffer protocol with an integer format (such as an array.array or a memoryview). When
+ * broadcasting is allowed, a single int can also be given, which is then repeated for every access
+ * in the batch.
+ */
+static const char* MmapDirectIO_buffer_format(const Py_buffer* view) {
+    const char* format = view->format == NULL ? "B" : view->format;
+
+    /* Only native byte ordering is supported. */
+    if (*format == '@' || *format == '=')
+        ++format;
+    return format;
+}
+
+static bool MmapDirectIO_is_unsigned_format(const char* format) {
+    return format[0] != '\0' && format[1] == '\0' && strchr("BHILQN", format[0]) != NULL;
+}
+
+static bool MmapDirectIO_is_integer_format(const char* format) {
+    return format[0] != '\0' && format[1] == '\0' && strchr("bhilqnBHILQN", format[0]) != NULL;
+}
+
+static int MmapDirectIO_buffer_item(
+    const Py_buffer* view, const char* format, Py_ssize_t i, bool truncate,
+    unsigned long long* item) {
+    const unsigned char* ptr = (const unsigned char*)view->buf + i * view->itemsize;
+    long long value;
+
+    switch (format[0]) {
+    case 'b': { signed char v; memcpy(&v, ptr, sizeof(v)); value = v; break; }
+    case 'h': { short v; memcpy(&v, ptr, sizeof(v)); value = v; break; }
+    case 'i': { int v; memcpy(&v, ptr, sizeof(v)); value = v; break; }
+    case 'l': { long v; memcpy(&v, ptr, sizeof(v)); value = v; break; }
+    case 'q': { long long v; memcpy(&v, ptr, sizeof(v)); value = v; break; }
+    case 'n': { Py_ssize_t v; memcpy(&v, ptr, sizeof(v)); value = v; break; }
+    case 'B': { unsigned char v; memcpy(&v, ptr, sizeof(v)); *item = v; return 0; }
+    case 'H': { unsigned short v; memcpy(&v, ptr, sizeof(v)); *item = v; return 0; }
+    case 'I': { unsigned int v; memcpy(&v, ptr, sizeof(v)); *item = v; return 0; }
+    case 'L': { unsigned long v; memcpy(&v, ptr, sizeof(v)); *item = v; return 0; }
+    case 'Q': { unsigned long long v; memcpy(&v, ptr, sizeof(v)); *item = v; return 0; }
+    case 'N': { size_t v; memcpy(&v, ptr, sizeof(v)); *item = v; return 0; }
+    default: value = -1; break; /* Format is validated by the caller. */
+    }
+
+    /* Negative values are only meaningful for data (such as inverted masks), not for offsets. */
+    if (value < 0 && !truncate) {
+        PyErr_Format(PyExc_ValueError, "Invalid negative value %lld at index %zd", value, i);
+        return -1;
+    }
+
+    *item = (unsigned long long)value;
+    return 0;
+}
+
+static void MmapDirectIO_buffer_set_item(
+    const Py_buffer* view, Py_ssize_t i, unsigned long long value) {
+    unsigned char* ptr = (unsigned char*)view->buf + i * view->itemsize;
+
+    switch (view->itemsize) {
+    case 1: { uint8_t v = value; memcpy(ptr, &v, sizeof(v)); break; }
+    case 2: { uint16_t v = value; memcpy(ptr, &v, sizeof(v)); break; }
+    case 4: { uint32_t v = value; memcpy(ptr, &v, sizeof(v)); break; }
+    case 8: { uint64_t v = value; memcpy(ptr, &v, sizeof(v)); break; }
+    default: break; /* Item size is validated by the caller. */
+    }
+}
+
+/*
+ * Convert an object providing a buffer of integers into a newly allocated array. Length handling is
+ * the same as for MmapDirectIO_vector_to_array. When truncate is set, negative items are converted
+ * using two's complement rather than being rejected.
+ */
+static unsigned long long* MmapDirectIO_buffer_to_array(
+    PyObject* obj, Py_ssize_t* len, const char* name, bool truncate) {
+    unsigned long long* array;
+    Py_buffer view;
+
+    if (PyObject_GetBuffer(obj, &view, PyBUF_FORMAT | PyBUF_C_CONTIGUOUS) < 0)
+        return NULL;
+
+    const char* format = MmapDirectIO_buffer_format(&view);
+    Py_ssize_t n = view.itemsize > 0 ? view.len / view.itemsize : 0;
+    if (!MmapDirectIO_is_integer_format(format)) {
+        PyErr_Format(PyExc_TypeError, "Invalid buffer format '%s' for %s", format, name);
+        array = NULL;
+    } else if (*len >= 0 && n != *len) {
+        PyErr_Format(PyExc_ValueError,
+                     "Length of %s (%zd) must match number of offsets (%zd)", name, n, *len);
+        array = NULL;
+    } else if ((array = PyMem_Malloc((n > 0 ? n : 1) * sizeof(*array))) == NULL) {
+        PyErr_NoMemory();
+    } else {
+        for (Py_ssize_t i = 0; i < n; ++i) {
+            if (MmapDirectIO_buffer_item(&view, format, i, truncate, &array[i]) < 0) {
+                PyMem_Free(array);
+                array = NULL;
+                break;
+            }
+        }
+    }
+
+    PyBuffer_Release(&view);
+    if (array != NULL)
+        *len = n;
+    return array;
+}
+
+/*
+ * Convert a vector into a newly allocated array. If len is negative on entry, the length is taken
+ * from the vector and broadcasting is not allowed. Otherwise, the vector must either match the
+ * given length or be a single int to broadcast. The array must be released with PyMem_Free.
+ */
+static unsigned long long* MmapDirectIO_vector_to_array(
+    PyObject* obj, Py_ssize_t* len, const char* name) {
+    unsigned long long* array;
+
+    /* Broadcast a single value. */
+    if (*len >= 0 && PyLong_Check(obj)) {
+        unsigned long long value = PyLong_AsUnsignedLongLong(obj);
+        if (value == (unsigned long long)-1 && PyErr_Occurred())
+            return NULL;
+
+        array = PyMem_Malloc((*len > 0 ? *len : 1) * sizeof(*array));
+        if (array == NULL)
+            return (unsigned long long*)PyErr_NoMemory();
+
+        for (Py_ssize_t i = 0; i < *len; ++i)
+            array[i] = value;
+        return array;
+    }
+
+    /* Extract from an object providing a buffer of integers. */
+    if (PyObject_CheckBuffer(obj))
+        return MmapDirectIO_buffer_to_array(obj, len, name, false);
+
+    /* Extract from a generic sequence. */
+    PyObject* seq = PySequence_Fast(obj, "Expected a sequence, buffer or int");
+    if (seq == NULL)
+        return NULL;
+
+    Py_ssize_t n = PySequence_Fast_GET_SIZE(seq);
+    if (*len >= 0 && n != *len) {
+        PyErr_Format(PyExc_ValueError,
+                     "Length of %s (%zd) must match number of offsets (%zd)", name, n, *len);
+        Py_DECREF(seq);
+        return NULL;
+    }
+
+    array = PyMem_Malloc((n > 0 ? n : 1) * sizeof(*array));
+    if (array == NULL) {
+        Py_DECREF(seq);
+        return (unsigned long long*)PyErr_NoMemory();
+    }
+
+    for (Py_ssize_t i = 0; i < n; ++i) {
+        PyObject* index = PyNumber_Index(PySequence_Fast_GET_ITEM(seq, i));
+        array[i] = index == NULL ? (unsigned long long)-1 : PyLong_AsUnsignedLongLong(index);
+        Py_XDECREF(index);
+
+        if (array[i] == (unsigned long long)-1 && PyErr_Occurred()) {
+            PyMem_Free(array);
+            Py_DECREF(seq);
+            return NULL;
+        }
+    }
+
+    Py_DECREF(seq);
+    *len = n;
+    return array;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+/* Check if all accesses of a batch are of up to 64 bits, so can be issued without the GIL. */
+static bool MmapDirectIO_sizes_fit(
+    const MmapDirectIO* self, const unsigned long long* sizes, Py_ssize_t count) {
+    for (Py_ssize_t i = 0; i < count; ++i) {
+        if (sizes[i] > 64 / self->word_width)
+            return false;
+    }
+    return true;
+}
+
+static PyObject* MmapDirectIO_read_many(PyObject* _self, PyObject* args, PyObject* kargs) {
+    static char *kargs_list[] = {
+        "offsets",
+        "sizes",
+        "out",
+        NULL
+    };
+
+    MmapDirectIO* self = (typeof(self))_self;
+    PyObject* offsets_obj;
+    PyObject* sizes_obj;
+    PyObject* out = Py_None;
+
+    if (!PyArg_ParseTupleAndKeywords(
+            args, kargs, "OO|O", kargs_list, &offsets_obj, &sizes_obj, &out))
+        return NULL;
+
+    Py_ssize_t count = -1;
+    unsigned long long* offsets = MmapDirectIO_vector_to_array(offsets_obj, &count, "offsets");
+    if (offsets == NULL)
+        return NULL;
+
+    unsigned long long* sizes = MmapDirectIO_vector_to_array(sizes_obj, &count, "sizes");
+    if (sizes == NULL) {
+        PyMem_Free(offsets);
+        return NULL;
+    }
+
+    PyObject* rv = NULL;
+    if (out == Py_None && MmapDirectIO_sizes_fit(self, sizes, count)) {
+        /* Read all values into an array before converting them, such that the GIL is released. */
+        unsigned long long* array = PyMem_Malloc((count > 0 ? count : 1) * sizeof(*array));
+        if (array == NULL) {
+            PyErr_NoMemory();
+        } else {
+            _begin_access(self);
+            for (Py_ssize_t i = 0; i < count; ++i)
+                array[i] = MmapDirectIO_read_ull(self, offsets[i], sizes[i]);
+            _end_access(self);
+
+            PyObject* values = PyList_New(count);
+            for (Py_ssize_t i = 0; values != NULL && i < count; ++i) {
+                PyObject* value = PyLong_FromUnsignedLongLong(array[i]);
+                if (value == NULL)
+                    Py_CLEAR(values);
+                else
+                    PyList_SET_ITEM(values, i, value);
+            }
+            PyMem_Free(array);
+            rv = values;
+        }
+    } else if (out == Py_None) {
+        /* Produce a list of ints, with no restrictions on the size of the accesses. */
+        PyObject* values = PyList_New(count);
+        for (Py_ssize_t i = 0; values != NULL && i < count; ++i) {
+            PyObject* value = sizes[i] <= 64 / self->word_width ?
+                PyLong_FromUnsignedLongLong(MmapDirectIO_read_ull(self, offsets[i], sizes[i])) :
+                MmapDirectIO_read_multi(self, offsets[i], sizes[i]);
+            if (value == NULL)
+                Py_CLEAR(values);
+            else
+                PyList_SET_ITEM(values, i, value);
+        }
+        rv = values;
+    } else {
+        /* Fill in the caller supplied buffer. */
+        Py_buffer view;
+        int flags = PyBUF_WRITABLE | PyBUF_FORMAT | PyBUF_C_CONTIGUOUS;
+        if (PyObject_GetBuffer(out, &view, flags) == 0) {
+            const char* format = MmapDirectIO_buffer_format(&view);
+            Py_ssize_t n = view.itemsize > 0 ? view.len / view.itemsize : 0;
+            Py_ssize_t i = 0;
+
+            if (!MmapDirectIO_is_unsigned_format(format)) {
+                PyErr_Format(PyExc_TypeError, "Invalid buffer format '%s' for out", format);
+            } else if (n < count) {
+                PyErr_Format(PyExc_ValueError,
+                             "Length of out (%zd) is less than number of offsets (%zd)", n, count);
+            } else {
+                /* Validate everything before issuing any reads to avoid partial side-effects. */
+                for (; i < count; ++i) {
+                    if (sizes[i] > (unsigned long long)view.itemsize * 8 / self->word_width) {
+                        PyErr_Format(PyExc_ValueError,
+                                     "Read size of %llu words at index %zd exceeds out item size",
+                                     sizes[i], i);
+                        break;
+                    }
+                }
+
+                if (i == count) {
+                    _begin_access(self);
+                    for (i = 0; i < count; ++i)
+                        MmapDirectIO_buffer_set_item(
+                            &view, i, MmapDirectIO_read_ull(self, offsets[i], sizes[i]));
+                    _end_access(self);
+
+                    Py_INCREF(out);
+                    rv = out;
+                }
+            }
+            PyBuffer_Release(&view);
+        }
+    }
+
+    PyMem_Free(sizes);
+    PyMem_Free(offsets);
+    return rv;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+/*
+ * Vector of data (values or masks) for batched writes/updates. Data given as a sequence of ints or
+ * as a single int to broadcast has no restrictions on the size of the accesses. Data given as a
+ * buffer is limited to accesses of up to 64 bits.
+ */
+typedef struct {
+    PyObject* seq;
+    PyObject* scalar;
+    unsigned long long* array;
+} MmapDirectIO_Data;
+
+static int MmapDirectIO_data_init(
+    MmapDirectIO_Data* data, PyObject* obj, Py_ssize_t count, const char* name) {
+    *data = (MmapDirectIO_Data){NULL, NULL, NULL};
+
+    if (PyLong_Check(obj)) {
+        Py_INCREF(obj);
+        data->scalar = obj;
+        return 0;
+    }
+
+    if (PyObject_CheckBuffer(obj)) {
+        data->array = MmapDirectIO_buffer_to_array(obj, &count, name, true);
+        return data->array == NULL ? -1 : 0;
+    }
+
+    data->seq = PySequence_Fast(obj, "Expected a sequence, buffer or int");
+    if (data->seq == NULL)
+        return -1;
+
+    Py_ssize_t n = PySequence_Fast_GET_SIZE(data->seq);
+    if (n != count) {
+        PyErr_Format(PyExc_ValueError,
+                     "Length of %s (%zd) must match number of offsets (%zd)", name, n, count);
+        Py_CLEAR(data->seq);
+        return -1;
+    }
+
+    /* Validate everything before issuing any accesses to avoid partial side-effects. */
+    for (Py_ssize_t i = 0; i < n; ++i) {
+        if (!PyLong_Check(PySequence_Fast_GET_ITEM(data->seq, i))) {
+            PyErr_Format(PyExc_TypeError, "Item %zd of %s must be an int", i, name);
+            Py_CLEAR(data->seq);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static void MmapDirectIO_data_release(MmapDirectIO_Data* data) {
+    Py_XDECREF(data->seq);
+    Py_XDECREF(data->scalar);
+    PyMem_Free(data->array);
+}
+
+/* Get the data item as a Python int, or NULL if only available as a C integer. */
+static PyObject* MmapDirectIO_data_object(const MmapDirectIO_Data* data, Py_ssize_t i) {
+    if (data->seq != NULL)
+        return PySequence_Fast_GET_ITEM(data->seq, i);
+    return data->scalar;
+}
+
+static unsigned long long MmapDirectIO_data_ull(const MmapDirectIO_Data* data, Py_ssize_t i) {
+    PyObject* obj = MmapDirectIO_data_object(data, i);
+
+    /* PyLong type is validated during init, so masked conversion can't fail. */
+    return obj == NULL ? data->array[i] : PyLong_AsUnsignedLongLongMask(obj);
+}
+
+/* Convert all data items to C integers, such that they can be accessed without the GIL. */
+static int MmapDirectIO_data_to_array(MmapDirectIO_Data* data, Py_ssize_t count) {
+    if (data->array != NULL)
+        return 0;
+
+    data->array = PyMem_Malloc((count > 0 ? count : 1) * sizeof(*data->array));
+    if (data->array == NULL) {
+        PyErr_NoMemory();
+        return -1;
+    }
+
+    for (Py_ssize_t i = 0; i < count; ++i)
+        data->array[i] = MmapDirectIO_data_ull(data, i);
+
+    Py_CLEAR(data->seq);
+    Py_CLEAR(data->scalar);
+    return 0;
+}
+
+static int MmapDirectIO_data_check(
+    const MmapDirectIO* self, const MmapDirectIO_Data* data, const unsigned long long* sizes,
+    Py_ssize_t count, const char* name) {
+    if (data->array == NULL)
+        return 0;
+
+    for (Py_ssize_t i = 0; i < count; ++i) {
+        if (sizes[i] > 64 / self->word_width) {
+            PyErr_Format(PyExc_ValueError,
+                         "Access size of %llu words at index %zd exceeds 64 bits for buffer %s",
+                         sizes[i], i, name);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+static PyObject* MmapDirectIO_write_many(PyObject* _self, PyObject* args, PyObject* kargs) {
+    static char *kargs_list[] = {
+        "offsets",
+        "sizes",
+        "values",
+        "barrier",
+        NULL
+    };
+
+    MmapDirectIO* self = (typeof(self))_self;
+    PyObject* offsets_obj;
+    PyObject* sizes_obj;
+    PyObject* values_obj;
+    int barrier = 0;
+
+    if (!PyArg_ParseTupleAndKeywords(
+            args, kargs, "OOO|p", kargs_list, &offsets_obj, &sizes_obj, &values_obj, &barrier))
+        return NULL;
+
+    Py_ssize_t count = -1;
+    unsigned long long* offsets = MmapDirectIO_vector_to_array(offsets_obj, &count, "offsets");
+    if (offsets == NULL)
+        return NULL;
+
+    unsigned long long* sizes = MmapDirectIO_vector_to_array(sizes_obj, &count, "sizes");
+    if (sizes == NULL) {
+        PyMem_Free(offsets);
+        return NULL;
+    }
+
+    MmapDirectIO_Data values;
+    PyObject* rv = NULL;
+    if (MmapDirectIO_data_init(&values, values_obj, count, "values") == 0) {
+        if (MmapDirectIO_data_check(self, &values, sizes, count, "values") == 0 &&
+            MmapDirectIO_sizes_fit(self, sizes, count)) {
+            /* Issue the stores in program order, without the GIL. */
+            if (MmapDirectIO_data_to_array(&values, count) == 0) {
+                _begin_access(self);
+                for (Py_ssize_t i = 0; i < count; ++i)
+                    MmapDirectIO_write_ull(self, offsets[i], sizes[i], values.array[i]);
+
+                if (barrier)
+                    _store_barrier();
+                _end_access(self);
+
+                Py_INCREF(Py_None);
+                rv = Py_None;
+            }
+        } else if (!PyErr_Occurred()) {
+            /* Issue the stores in program order. */
+            Py_ssize_t i = 0;
+            for (; i < count; ++i) {
+                if (sizes[i] <= 64 / self->word_width) {
+                    MmapDirectIO_write_ull(
+                        self, offsets[i], sizes[i], MmapDirectIO_data_ull(&values, i));
+                } else {
+                    PyObject* value = MmapDirectIO_data_object(&values, i);
+                    PyObject* res = MmapDirectIO_write_multi(self, offsets[i], sizes[i], value);
+                    if (res == NULL)
+                        break;
+                    Py_DECREF(res);
+                }
+            }
+
+            if (barrier)
+                _store_barrier();
+
+            if (i == count) {
+                Py_INCREF(Py_None);
+                rv = Py_None;
+            }
+        }
+        MmapDirectIO_data_release(&values);
+    }
+
+    PyMem_Free(sizes);
+    PyMem_Free(offsets);
+    return rv;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+static PyObject* MmapDirectIO_update_many(PyObject* _self, PyObject* args, PyObject* kargs) {
+    static char *kargs_list[] = {
+        "offsets",
+        "sizes",
+        "clr_masks",
+        "set_masks",
+        "barrier",
+        NULL
+    };
+
+    MmapDirectIO* self = (typeof(self))_self;
+    PyObject* offsets_obj;
+    PyObject* sizes_obj;
+    PyObject* clr_masks_obj;
+    PyObject* set_masks_obj;
+    int barrier = 0;
+
+    if (!PyArg_ParseTupleAndKeywords(
+            args, kargs, "OOOO|p", kargs_list, &offsets_obj, &sizes_obj,
+            &clr_masks_obj, &set_masks_obj, &barrier))
+        return NULL;
+
+    Py_ssize_t count = -1;
+    unsigned long long* offsets = MmapDirectIO_vector_to_array(offsets_obj, &count, "offsets");
+    if (offsets == NULL)
+        return NULL;
+
+    unsigned long long* sizes = MmapDirectIO_vector_to_array(sizes_obj, &count, "sizes");
+    if (sizes == NULL) {
+        PyMem_Free(offsets);
+        return NULL;
+    }
+
+    MmapDirectIO_Data clr_masks;
+    MmapDirectIO_Data set_masks;
+    PyObject* rv = NULL;
+    if (MmapDirectIO_data_init(&clr_masks, clr_masks_obj, count, "clr_masks") == 0) {
+        if (MmapDirectIO_data_init(&set_masks, set_masks_obj, count, "set_masks") == 0) {
+            if (MmapDirectIO_data_check(self, &clr_masks, sizes, count, "clr_masks") == 0 &&
+                MmapDirectIO_data_check(self, &set_masks, sizes, count, "set_masks") == 0 &&
+                MmapDirectIO_sizes_fit(self, sizes, count)) {
+                /* Issue the read-modify-writes in program order, without the GIL. */
+                if (MmapDirectIO_data_to_array(&clr_masks, count) == 0 &&
+                    MmapDirectIO_data_to_array(&set_masks, count) == 0) {
+                    _begin_access(self);
+                    for (Py_ssize_t i = 0; i < count; ++i)
+                        MmapDirectIO_update_ull(
+                            self, offsets[i], sizes[i], clr_masks.array[i], set_masks.array[i]);
+
+                    if (barrier)
+                        _store_barrier();
+                    _end_access(self);
+
+                    Py_INCREF(Py_None);
+                    rv = Py_None;
+                }
+            } else if (!PyErr_Occurred()) {
+                /* Issue the read-modify-writes in program order. */
+                Py_ssize_t i = 0;
+                for (; i < count; ++i) {
+                    if (sizes[i] <= 64 / self->word_width) {
+                        MmapDirectIO_update_ull(
+                            self, offsets[i], sizes[i],
+                            MmapDirectIO_data_ull(&clr_masks, i),
+                            MmapDirectIO_data_ull(&set_masks, i));
+                    } else {
+                        PyObject* res = MmapDirectIO_update_multi(
+                            self, offsets[i], sizes[i],
+                            MmapDirectIO_data_object(&clr_masks, i),
+                            MmapDirectIO_data_object(&set_masks, i));
+                        if (res == NULL)
+                            break;
+                        Py_DECREF(res);
+                    }
+                }
+
+                if (barrier)
+                    _store_barrier();
+
+                if (i == count) {
+                    Py_INCREF(Py_None);
+                    rv = Py_None;
+                }
+            }
+            MmapDirectIO_data_release(&set_masks);
+        }
+        MmapDirectIO_data_release(&clr_masks);
+    }
+
+    PyMem_Free(sizes);
+    PyMem_Free(offsets);
+    return rv;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+/*
+ * Poll an access of up to 64 bits until the bits selected by mask read as value, returning the last
+ * value read. Polling starts out spinning, with a doubling number of CPU pause hints between reads,
+ * then sleeps between reads, doubling the delay up to the backoff limit. The GIL is released while
+ * polling and periodically re-acquired to check for signals (such as a KeyboardInterrupt), so
+ * scripts waiting on hardware neither hold up other threads nor burn a core in the interpreter.
+ */
+#if defined(__x86_64__) || defined(__i386__)
+#define _cpu_pause() __asm__ __volatile__("pause" ::: "memory")
+#elif defined(__aarch64__)
+#define _cpu_pause() __asm__ __volatile__("yield" ::: "memory")
+#else
+#define _cpu_pause() __asm__ __volatile__("" ::: "memory")
+#endif
+
+#define MMAP_DIRECT_IO_POLL_SPINS 10 /* Rounds of spinning, ending with 2^(N-1) pauses per read. */
+#define MMAP_DIRECT_IO_POLL_SLEEP_NS 1000ULL /* Initial delay between reads once sleeping. */
+#define MMAP_DIRECT_IO_POLL_SIGNALS_NS 50000000ULL /* Interval between checks for signals. */
+
+static unsigned long long MmapDirectIO_monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + (unsigned long long)ts.tv_nsec;
+}
+
+static void MmapDirectIO_sleep_ns(unsigned long long ns) {
+    struct timespec ts = {
+        .tv_sec = (time_t)(ns / 1000000000ULL),
+        .tv_nsec = (long)(ns % 1000000000ULL),
+    };
+    nanosleep(&ts, NULL);
+}
+
+static PyObject* MmapDirectIO_poll_until(PyObject* _self, PyObject* args, PyObject* kargs) {
+    static char *kargs_list[] = {
+        "offset",
+        "size",
+        "mask",
+        "value",
+        "timeout",
+        "backoff",
+        NULL
+    };
+
+    MmapDirectIO* self = (typeof(self))_self;
+    unsigned long long offset;
+    unsigned long long size;
+    unsigned long long mask;
+    unsigned long long value;
+    PyObject* timeout_obj = Py_None;
+    double backoff = 1e-3;
+
+    if (!PyArg_ParseTupleAndKeywords(
+            args, kargs, "KKKK|Od", kargs_list,
+            &offset, &size, &mask, &value, &timeout_obj, &backoff))
+        return NULL;
+
+    if (size == 0 || size > 64 / self->word_width) {
+        PyErr_Format(PyExc_ValueError, "Polled size %llu must be of 1 to %u words",
+                     size, 64 / self->word_width);
+        return NULL;
+    }
+
+    /* Timeout and backoff are given as seconds. Without a timeout, polling never gives up. */
+    bool has_deadline = timeout_obj != Py_None;
+    double timeout = 0.0;
+    if (has_deadline) {
+        timeout = PyFloat_AsDouble(timeout_obj);
+        if (timeout == -1.0 && PyErr_Occurred())
+            return NULL;
+    }
+
+    if (timeout < 0.0 || backoff < 0.0) {
+        PyErr_SetString(PyExc_ValueError, "Timeout and backoff must not be negative");
+        return NULL;
+    }
+
+    unsigned long long max_delay = (unsigned long long)(backoff * 1e9);
+    unsigned long long now = MmapDirectIO_monotonic_ns();
+    unsigned long long deadline = now + (unsigned long long)(timeout * 1e9);
+    unsigned long long delay = MMAP_DIRECT_IO_POLL_SLEEP_NS;
+    unsigned int spins = 0;
+    unsigned long long v = 0;
+    bool matched = false;
+    bool expired = false;
+
+    value &= mask;
+    while (true) {
+        unsigned long long signals = now + MMAP_DIRECT_IO_POLL_SIGNALS_NS;
+        _begin_access(self);
+        while (true) {
+            v = MmapDirectIO_read_ull(self, offset, size);
+            if ((v & mask) == value) {
+                matched = true;
+                break;
+            }
+
+            now = MmapDirectIO_monotonic_ns();
+            if (has_deadline && now >= deadline) {
+                expired = true;
+                break;
+            }
+            if (now >= signals)
+                break;
+
+            if (spins < MMAP_DIRECT_IO_POLL_SPINS) {
+                for (unsigned int i = 0; i < (1U << spins); ++i)
+                    _cpu_pause();
+                ++spins;
+            } else {
+                unsigned long long ns = delay < max_delay ? delay : max_delay;
+                if (has_deadline && ns > deadline - now)
+                    ns = deadline - now;
+                MmapDirectIO_sleep_ns(ns);
+                delay = delay * 2 < max_delay ? delay * 2 : max_delay;
+            }
+        }
+        _end_access(self);
+
+        if (matched)
+            return PyLong_FromUnsignedLongLong(v);
+
+        if (expired) {
+            /* Formatted here, since PyErr_Format only gained hexadecimal long longs in 3.12. */
+            char msg[128];
+            snprintf(msg, sizeof(msg),
+                     "Timed out polling offset 0x%llx for 0x%llx under mask 0x%llx "
+                     "(last read 0x%llx)", offset, value, mask, v);
+            PyErr_SetString(PyExc_TimeoutError, msg);
+            return NULL;
+        }
+
+        if (PyErr_CheckSignals() < 0)
+            return NULL;
+    }
+}
+
+/*------------------------------------------------------------------------------------------------*/
+/*
+ * Export the memory mapped region through the buffer protocol as a one dimensional array of words.
+ * Note that copying from such a buffer (via memoryview, numpy, etc) is done with memcpy semantics,
+ * which doesn't guarantee the width or count of accesses. Use read_many for side-effect sensitive
+ * registers.
+ */
+static int MmapDirectIO_getbuffer(PyObject* _self, Py_buffer* view, int flags) {
+    MmapDirectIO* self = (typeof(self))_self;
+
+    if (self->size == 0) {
+        PyErr_SetString(PyExc_BufferError, "Size of memory mapped region is unknown");
+        view->obj = NULL;
+        return -1;
+    }
+
+    /* Use native formats when possible, since they're the only ones supported by memoryview. */
+    const char* format;
+    bool native = self->little_endian == (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__);
+    switch (self->word_width) {
+    case 8: format = "B"; break;
+    case 16: format = native ? "H" : self->little_endian ? "<H" : ">H"; break;
+    case 32: format = native ? "I" : self->little_endian ? "<I" : ">I"; break;
+    case 64: format = native ? "Q" : self->little_endian ? "<Q" : ">Q"; break;
+    default: format = "B"; break; /* word_width is validated during init and is read-only. */
+    }
+
+    view->obj = _self;
+    view->buf = (void*)self->base_addr;
+    view->itemsize = self->word_width / 8;
+    view->len = self->size * view->itemsize;
+    view->readonly = 0;
+    view->format = (flags & PyBUF_FORMAT) == PyBUF_FORMAT ? (char*)format : NULL;
+    view->ndim = 1;
+    view->shape = (flags & PyBUF_ND) == PyBUF_ND ? &self->size : NULL;
+    view->strides = (flags & PyBUF_STRIDES) == PyBUF_STRIDES ? &view->itemsize : NULL;
+    view->suboffsets = NULL;
+    view->internal = NULL;
+
+    Py_INCREF(_self);
+    ++self->exports;
+    return 0;
+}
+
+static void MmapDirectIO_releasebuffer(PyObject* _self, Py_buffer* Py_UNUSED(view)) {
+    MmapDirectIO* self = (typeof(self))_self;
+    --self->exports;
+}
+
+static PyBufferProcs MmapDirectIO_as_buffer = {
+    .bf_getbuffer = MmapDirectIO_getbuffer,
+    .bf_releasebuffer = MmapDirectIO_releasebuffer,
+};
+
 /*------------------------------------------------------------------------------------------------*/
 static PyMethodDef MmapDirectIO_methods[] = {
     {
@@ -279,6 +1470,35 @@ static PyMethodDef MmapDirectIO_methods[] = {
         .ml_flags = METH_VARARGS,
         .ml_doc = "Update size words starting at the given offset.",
     },
+    {
+        .ml_name = "read_many",
+        .ml_meth = (PyCFunction)(void(*)(void))MmapDirectIO_read_many,
+        .ml_flags = METH_VARARGS | METH_KEYWORDS,
+        .ml_doc = "Read sizes words starting from each of the given offsets. The results are "
+                  "stored into the out buffer if given, otherwise they are returned as a list.",
+    },
+    {
+        .ml_name = "write_many",
+        .ml_meth = (PyCFunction)(void(*)(void))MmapDirectIO_write_many,
+        .ml_flags = METH_VARARGS | METH_KEYWORDS,
+        .ml_doc = "Write sizes words starting at each of the given offsets, in order. Optionally "
+                  "issue a store barrier once all writes are done.",
+    },
+    {
+        .ml_name = "update_many",
+        .ml_meth = (PyCFunction)(void(*)(void))MmapDirectIO_update_many,
+        .ml_flags = METH_VARARGS | METH_KEYWORDS,
+        .ml_doc = "Update sizes words starting at each of the given offsets, in order. Optionally "
+                  "issue a store barrier once all updates are done.",
+    },
+    {
+        .ml_name = "poll_until",
+        .ml_meth = (PyCFunction)(void(*)(void))MmapDirectIO_poll_until,
+        .ml_flags = METH_VARARGS | METH_KEYWORDS,
+        .ml_doc = "Read size words from the given offset until the bits under mask match value, "
+                  "returning the last value read. Raises TimeoutError if timeout seconds elapse "
+                  "first. Delays between reads grow up to backoff seconds.",
+    },
     {}
 };
 
@@ -312,6 +1532,34 @@ static PyMemberDef MmapDirectIO_members[] = {
         .flags = READONLY,
         .doc = "Endianess of the memory mapped region."
     },
+    {
+        .name = "size",
+        .type = T_PYSSIZET,
+        .offset = offsetof(MmapDirectIO, size),
+        .flags = READONLY,
+        .doc = "Size of the memory mapped region (in words). Zero if unknown."
+    },
+    {
+        .name = "exports",
+        .type = T_PYSSIZET,
+        .offset = offsetof(MmapDirectIO, exports),
+        .flags = READONLY,
+        .doc = "Number of buffers currently exported over the memory mapped region."
+    },
+    {
+        .name = "accesses",
+        .type = T_PYSSIZET,
+        .offset = offsetof(MmapDirectIO, accesses),
+        .flags = READONLY,
+        .doc = "Number of accesses currently in progress without holding the GIL."
+    },
+    {
+        .name = "release_gil",
+        .type = T_BOOL,
+        .offset = offsetof(MmapDirectIO, release_gil),
+        .flags = READONLY,
+        .doc = "Release the GIL around single word accesses."
+    },
     {}
 };
 
@@ -328,6 +1576,7 @@ static PyTypeObject MmapDirectIOType = {
     .tp_repr = MmapDirectIO_repr,
     .tp_methods = MmapDirectIO_methods,
     .tp_members = MmapDirectIO_members,
+    .tp_as_buffer = &MmapDirectIO_as_buffer,
 };
 
 /*------------------------------------------------------------------------------------------------*/
@@ -0,0 +1,466 @@
+#---------------------------------------------------------------------------------------------------
+__all__ = ()
+
+import array
+import asyncio
+import socket
+import socketserver
+import struct
+import sys
+import threading
+
+from . import io
+
+#---------------------------------------------------------------------------------------------------
+# Wire protocol for serving the IO of regmaps over a stream socket. Every request and response is a
+# frame made up of a fixed size header followed by a body (all integers are little endian):
+#   header:  body size, request ID, opcode (status for responses), flags, target handle
+#
+# A client first opens a target by name (the body), getting back its handle in the header and its
+# data width in the body. Reads, writes and updates are always batched, with a body made up of the
+# access count, the sizes (a single size when uniform) and the offsets, followed by the values for
+# writes or the clear and set mask pairs for updates. Each value and mask spans the access size in
+# words. The body of a read response holds the values read in the same way, while the body of an
+# error response holds the error message.
+#
+# Requests on a connection are handled in order, with one response per request. Clients may issue
+# any number of requests before waiting on the responses, which are matched up by request ID.
+HEADER = struct.Struct('<IIBBH')
+COUNT = struct.Struct('<I')
+WIDTH = struct.Struct('<I')
+MAX_BODY_SIZE = 1 << 26
+
+OP_OPEN = 1
+OP_READ = 2
+OP_WRITE = 3
+OP_UPDATE = 4
+
+STATUS_OK = 0
+STATUS_ERROR = 1
+
+FLAG_BARRIER = 0x1
+FLAG_UNIFORM = 0x2 # All accesses are of the same size.
+FLAG_COMBINED = 0x4 # Writes may be combined (see IO.write_combined).
+
+DEFAULT_PORT = 7588
+
+# Batches of single word accesses are packed to and from arrays, without converting each value.
+ARRAY_FORMATS = {1: 'B', 2: 'H', 4: 'I', 8: 'Q'}
+BYTESWAP = sys.byteorder != 'little'
+
+class RemoteError(IOError): ...
+
+def parse_address(address):
+    # Addresses are given as 'host:port', 'host' or (host, port).
+    if isinstance(address, tuple):
+        return address
+    host, sep, port = address.rpartition(':')
+    if not sep:
+        return (address, DEFAULT_PORT)
+    return (host.strip('[]'), int(port))
+
+#---------------------------------------------------------------------------------------------------
+def _to_array(fmt, data):
+    values = array.array(fmt)
+    values.frombytes(data)
+    if BYTESWAP:
+        values.byteswap()
+    return values
+
+def _from_array(fmt, values):
+    values = array.array(fmt, values)
+    if BYTESWAP:
+        values.byteswap()
+    return values.tobytes()
+
+def pack_values(octets, sizes, values, count):
+    # Pack count values, each spanning its access size in words.
+    if isinstance(sizes, int):
+        fmt = ARRAY_FORMATS.get(octets * sizes)
+        if fmt is not None:
+            try:
+                return _from_array(fmt, values)
+            except (OverflowError, TypeError):
+                ... # Values out of range (such as negative masks) need truncating.
+        sizes = (sizes,) * count
+
+    data = bytearray()
+    for size, value in zip(sizes, values):
+        nbytes = size * octets
+        data += (value & ((1 << (8 * nbytes)) - 1)).to_bytes(nbytes, 'little')
+    return bytes(data)
+
+def unpack_values(octets, sizes, data, count, pos=0, stride=1):
+    # Unpack count values starting from pos, with stride values per access (of which only the first
+    # is returned).
+    if isinstance(sizes, int):
+        nbytes = sizes * octets
+        fmt = ARRAY_FORMATS.get(nbytes)
+        if fmt is not None and stride == 1:
+            return _to_array(fmt, data[pos:pos + count * nbytes])
+        sizes = (sizes,) * count
+
+    values = []
+    for size in sizes:
+        nbytes = size * octets
+        values.append(int.from_bytes(data[pos:pos + nbytes], 'little'))
+        pos += nbytes * stride
+    return values
+
+def pack_batch(octets, offsets, sizes):
+    count = len(offsets)
+    if isinstance(sizes, int):
+        flags = FLAG_UNIFORM
+        data = COUNT.pack(count) + struct.pack('<I', sizes)
+    else:
+        if len(sizes) != count:
+            raise ValueError(
+                f'Length of sizes ({len(sizes)}) must match number of offsets ({count}).')
+        flags = 0
+        data = COUNT.pack(count) + _from_array('I', sizes)
+    return flags, data + _from_array('Q', offsets)
+
+def unpack_batch(flags, data):
+    # Returns the offsets, sizes and position of the values in the data.
+    count, = COUNT.unpack_from(data)
+    pos = COUNT.size
+    if flags & FLAG_UNIFORM:
+        sizes, = struct.unpack_from('<I', data, pos)
+        pos += 4
+    else:
+        sizes = _to_array('I', data[pos:pos + 4 * count])
+        pos += 4 * count
+    offsets = _to_array('Q', data[pos:pos + 8 * count])
+    pos += 8 * count
+    if len(offsets) != count:
+        raise ValueError(f'Truncated batch of {count} accesses.')
+    return offsets, sizes, pos
+
+#---------------------------------------------------------------------------------------------------
+# Serves the IO objects of any number of targets (given as a mapping of names to (io, data_width,
+# size) tuples, with the size in words) to remote clients, with a thread per connection. The IO
+# objects must already be started. Accesses outside of a target's size are refused. Accesses to
+# each target are serialized by a lock, so they needn't be shareable between threads.
+# Batches are passed as a whole to the batched IO interface, which maps onto the native batched
+# paths of memory mapped IO. Note that any client able to connect can access the targets, so the
+# server should be bound to a trusted interface (by default, only to localhost).
+class RegisterServer(socketserver.ThreadingTCPServer):
+    allow_reuse_address = True
+    daemon_threads = True
+
+    def __init__(self, address, targets):
+        self.names = tuple(targets)
+        self.targets = tuple(
+            (llio, data_width // 8, size, threading.Lock())
+            for llio, data_width, size in targets.values())
+        self.widths = tuple(data_width for _, data_width, _ in targets.values())
+        super().__init__(parse_address(address), RegisterHandler)
+
+    @property
+    def address(self):
+        host, port = self.server_address[:2]
+        return f'{host}:{port}'
+
+    def dispatch(self, op, flags, handle, body):
+        # Perform a request, returning the handle and body of the response.
+        if op == OP_OPEN:
+            name = bytes(body).decode()
+            if name not in self.names:
+                raise KeyError(
+                    f'Unknown target "{name}". Available targets are: {", ".join(self.names)}.')
+            handle = self.names.index(name)
+            return handle, WIDTH.pack(self.widths[handle])
+
+        if handle >= len(self.targets):
+            raise KeyError(f'Invalid target handle {handle}.')
+        llio, octets, limit, lock = self.targets[handle]
+        offsets, sizes, pos = unpack_batch(flags, body)
+        count = len(offsets)
+        barrier = bool(flags & FLAG_BARRIER)
+        if count > 0:
+            if isinstance(sizes, int):
+                end = max(offsets) + sizes
+            else:
+                end = max(offset + size for offset, size in zip(offsets, sizes))
+            if end > limit:
+                raise IndexError(f'Access up to offset 0x{end:x} is beyond 0x{limit:x} words.')
+
+        if op == OP_READ:
+            with lock:
+                values = llio.read_many(offsets, sizes)
+            return handle, pack_values(octets, sizes, values, count)
+
+        if op == OP_WRITE:
+            values = unpack_values(octets, sizes, body, count, pos)
+            with lock:
+                if flags & FLAG_COMBINED:
+                    llio.write_combined(offsets, sizes, values)
+                else:
+                    llio.write_many(offsets, sizes, values, barrier)
+            return handle, b''
+
+        if op == OP_UPDATE:
+            # Clear and set masks are interleaved per access.
+            nbytes = sizes * octets if isinstance(sizes, int) else None
+            clr_masks = unpack_values(octets, sizes, body, count, pos, 2)
+            if nbytes is not None:
+                set_masks = unpack_values(octets, sizes, body, count, pos + nbytes, 2)
+            else:
+                set_masks = []
+                for size in sizes:
+                    pos += size * octets
+                    set_masks.append(int.from_bytes(body[pos:pos + size * octets], 'little'))
+                    pos += size * octets
+            with lock:
+                llio.update_many(offsets, sizes, clr_masks, set_masks, barrier)
+            return handle, b''
+
+        raise ValueError(f'Invalid opcode {op}.')
+
+class RegisterHandler(socketserver.StreamRequestHandler):
+    def handle(self):
+        self.request.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        while True:
+            header = self.rfile.read(HEADER.size)
+            if len(header) < HEADER.size:
+                return # Connection closed.
+
+            size, rid, op, flags, handle = HEADER.unpack(header)
+            if size > MAX_BODY_SIZE:
+                return # Not a client speaking the protocol.
+
+            body = self.rfile.read(size)
+            if len(body) < size:
+                return
+
+            try:
+                handle, reply = self.server.dispatch(op, flags, handle, body)
+                status = STATUS_OK
+            except Exception as e:
+                reply = f'{type(e).__name__}: {e}'.encode()
+                status = STATUS_ERROR
+            self.wfile.write(HEADER.pack(len(reply), rid, status, 0, handle) + reply)
+
+#---------------------------------------------------------------------------------------------------
+# Client side IO on a target of a RegisterServer. Every access is a single request (batched ones
+# included), so should be batched wherever possible to amortize the round trip. When started with
+# astart (or 'async with'), only the awaitable interface can be used, with any number of requests
+# pipelined on the connection at once.
+class RemoteIO(io.IO):
+    def __init__(self, address, target, timeout=None, *pargs, **kargs):
+        super().__init__(*pargs, **kargs)
+
+        self.address = parse_address(address)
+        self.target = target
+        self.timeout = timeout
+        self._rid = 0
+        self._sock = None
+        self._writer = None
+
+    def _frame(self, op, flags, body):
+        self._rid = (self._rid + 1) & 0xffffffff
+        return self._rid, HEADER.pack(len(body), self._rid, op, flags, self._handle) + body
+
+    def _response(self, rid, header, body):
+        size, rrid, status, _, handle = header
+        if rrid != rid:
+            raise RemoteError(f'{self.target}: Response {rrid} doesn\'t match request {rid}.')
+        if status != STATUS_OK:
+            raise RemoteError(f'{self.target}: {bytes(body).decode(errors="replace")}')
+        return handle, body
+
+    def _opened(self, handle, body):
+        self._handle = handle
+        self.data_width, = WIDTH.unpack(body)
+        self.octets = self.data_width // 8
+
+    #-----------------------------------------------------------------------------------------------
+    def start(self):
+        if not self.started:
+            self._sock = socket.create_connection(self.address, self.timeout)
+            self._sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+            self._rfile = self._sock.makefile('rb')
+            self._handle = 0
+            try:
+                self._opened(*self._request(OP_OPEN, 0, self.target.encode()))
+            except Exception:
+                self._close()
+                raise
+            super().start()
+
+    def _close(self):
+        self._rfile.close()
+        self._sock.close()
+        self._sock = None
+        del self._rfile
+
+    def stop(self):
+        if self.started and self._sock is not None:
+            self._close()
+            super().stop()
+
+    def _request(self, op, flags, body):
+        if self._sock is None:
+            raise RuntimeError(f'{self.target}: Synchronous access on an asynchronous connection.')
+
+        rid, frame = self._frame(op, flags, body)
+        self._sock.sendall(frame)
+        header = self._rfile.read(HEADER.size)
+        if len(header) < HEADER.size:
+            raise RemoteError(f'{self.target}: Connection closed by the server.')
+        header = HEADER.unpack(header)
+        body = self._rfile.read(header[0])
+        if len(body) < header[0]:
+            raise RemoteError(f'{self.target}: Connection closed by the server.')
+        return self._response(rid, header, body)
+
+    #-----------------------------------------------------------------------------------------------
+    def _read_request(self, offsets, sizes):
+        # Sizes are normalized to keep batches uniform when possible.
+        sizes = self._sizes(offsets, sizes)
+        flags, body = pack_batch(self.octets, offsets, sizes)
+        return sizes, flags, body
+
+    def _write_request(self, offsets, sizes, values, barrier):
+        sizes = self._sizes(offsets, sizes)
+        count = len(offsets)
+        values = list(self.broadcast('values', values, count))
+        flags, body = pack_batch(self.octets, offsets, sizes)
+        flags |= FLAG_BARRIER if barrier else 0
+        return flags, body + pack_values(self.octets, sizes, values, count)
+
+    def _update_request(self, offsets, sizes, clr_masks, set_masks, barrier):
+        sizes = self._sizes(offsets, sizes)
+        count = len(offsets)
+        clr_masks = self.broadcast('clr_masks', clr_masks, count)
+        set_masks = self.broadcast('set_masks', set_masks, count)
+        masks = [mask for pair in zip(clr_masks, set_masks) for mask in pair]
+        flags, body = pack_batch(self.octets, offsets, sizes)
+        flags |= FLAG_BARRIER if barrier else 0
+        if not isinstance(sizes, int):
+            sizes = [size for size in sizes for _ in range(2)]
+        return flags, body + pack_values(self.octets, sizes, masks, 2 * count)
+
+    @staticmethod
+    def _sizes(offsets, sizes):
+        if isinstance(sizes, int):
+            return sizes
+        if len(sizes) != len(offsets):
+            raise ValueError(
+                f'Length of sizes ({len(sizes)}) must match number of offsets ({len(offsets)}).')
+        if len(sizes) > 0 and all(size == sizes[0] for size in sizes):
+            return sizes[0]
+        return sizes
+
+    def _values(self, sizes, data, count, out):
+        values = unpack_values(self.octets, sizes, data, count)
+        if out is None:
+            return values.tolist() if isinstance(values, array.array) else values
+        return self.fill(out, values)
+
+    def read(self, offset, size):
+        return self.read_many((offset,), size)[0]
+
+    def write(self, offset, size, value):
+        self.write_many((offset,), size, (value,))
+
+    def update(self, offset, size, clr_mask, set_mask):
+        self.update_many((offset,), size, (clr_mask,), (set_mask,))
+
+    def read_many(self, offsets, sizes, out=None):
+        sizes, flags, body = self._read_request(offsets, sizes)
+        _, data = self._request(OP_READ, flags, body)
+        return self._values(sizes, data, len(offsets), out)
+
+    def write_many(self, offsets, sizes, values, barrier=False):
+        self._request(OP_WRITE, *self._write_request(offsets, sizes, values, barrier))
+
+    def update_many(self, offsets, sizes, clr_masks, set_masks, barrier=False):
+        self._request(
+            OP_UPDATE, *self._update_request(offsets, sizes, clr_masks, set_masks, barrier))
+
+    def write_combined(self, offsets, sizes, values):
+        flags, body = self._write_request(offsets, sizes, values, True)
+        self._request(OP_WRITE, flags | FLAG_COMBINED, body)
+
+    #-----------------------------------------------------------------------------------------------
+    async def astart(self):
+        if not self.started:
+            self._reader, self._writer = await asyncio.open_connection(*self.address)
+            self._writer.get_extra_info('socket').setsockopt(
+                socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+            self._pending = {}
+            self._handle = 0
+            self._receiver = asyncio.create_task(self._receive())
+            try:
+                self._opened(*await self._arequest(OP_OPEN, 0, self.target.encode()))
+            except Exception:
+                await self._aclose()
+                raise
+            super().start()
+
+    async def _aclose(self):
+        self._receiver.cancel()
+        self._writer.close()
+        try:
+            await self._writer.wait_closed()
+        except (ConnectionError, asyncio.CancelledError):
+            ...
+        del self._reader, self._writer, self._receiver
+        self._writer = None
+
+    async def astop(self):
+        if self.started and self._writer is not None:
+            await self._aclose()
+            super().stop()
+
+    async def _receive(self):
+        # Complete the pending requests as their responses arrive.
+        pending = self._pending
+        try:
+            while True:
+                header = HEADER.unpack(await self._reader.readexactly(HEADER.size))
+                body = await self._reader.readexactly(header[0])
+                future = pending.pop(header[1], None)
+                if future is not None and not future.done():
+                    future.set_result((header, body))
+        except (asyncio.IncompleteReadError, ConnectionError) as e:
+            error = RemoteError(f'{self.target}: Connection closed by the server.')
+            error.__cause__ = e
+            for future in pending.values():
+                if not future.done():
+                    future.set_exception(error)
+            pending.clear()
+
+    async def _arequest(self, op, flags, body):
+        if self._writer is None:
+            raise RuntimeError(f'{self.target}: Asynchronous access on a synchronous connection.')
+
+        rid, frame = self._frame(op, flags, body)
+        future = asyncio.get_running_loop().create_future()
+        self._pending[rid] = future
+        self._writer.write(frame)
+        await self._writer.drain()
+        header, body = await future
+        return self._response(rid, header, body)
+
+    async def aread(self, offset, size):
+        return (await self.aread_many((offset,), size))[0]
+
+    async def awrite(self, offset, size, value):
+        await self.awrite_many((offset,), size, (value,))
+
+    async def aupdate(self, offset, size, clr_mask, set_mask):
+        await self.aupdate_many((offset,), size, (clr_mask,), (set_mask,))
+
+    async def aread_many(self, offsets, sizes, out=None):
+        sizes, flags, body = self._read_request(offsets, sizes)
+        _, data = await self._arequest(OP_READ, flags, body)
+        return self._values(sizes, data, len(offsets), out)
+
+    async def awrite_many(self, offsets, sizes, values, barrier=False):
+        await self._arequest(OP_WRITE, *self._write_request(offsets, sizes, values, barrier))
+
+    async def aupdate_many(self, offsets, sizes, clr_masks, set_masks, barrier=False):
+        await self._arequest(
+            OP_UPDATE, *self._update_request(offsets, sizes, clr_masks, set_masks, barrier))
@@ -0,0 +1,320 @@
+#---------------------------------------------------------------------------------------------------
+__all__ = ()
+
+import collections
+import itertools
+import pathlib
+import time
+
+from . import mmap
+from .io import Endian
+from .trace import Kind, WRITE, UPDATE
+from ..spec import info
+
+#---------------------------------------------------------------------------------------------------
+SHM_DIR = pathlib.Path('/dev/shm')
+HUGEPAGES_DIR = pathlib.Path('/dev/hugepages')
+MEMINFO_PATH = pathlib.Path('/proc/meminfo')
+
+def hugepage_size():
+    # Default size in bytes of the huge pages backing hugetlbfs mounts.
+    with MEMINFO_PATH.open('r') as fo:
+        for line in fo:
+            if line.startswith('Hugepagesize:'):
+                return int(line.split()[1]) * 1024
+    raise OSError(f'{MEMINFO_PATH}: Huge pages are not supported.')
+
+#---------------------------------------------------------------------------------------------------
+# Ring of notifications from a process making writes to a shared memory region to a process serving
+# them (such as an RTL simulator or register model). The ring is held in its own shared memory file
+# as an array of 64 bit little endian words:
+#   header:  magic, version and depth (in entries) at word 0, the head count at word 8 and the tail
+#            count at word 16 (each on its own cache line)
+#   entries: depth entries of 4 words from word 24: offset, size | kind << 32, value (the set mask
+#            for updates) and clear mask (only for updates)
+#
+# The producer fills the entries at its head and then stores the advanced head count, with a store
+# barrier in between. The consumer handles the entries from its tail up to the head, then stores the
+# advanced tail count. Values and masks are truncated to 64 bits, with the consumer reading wider
+# registers from the shared memory region itself. When the ring is full, the producer waits for the
+# consumer. In sync mode, the producer also waits for each notification to be consumed, such that
+# the side-effects of writes are visible to any subsequent access, provided the consumer only
+# advances the tail once it has handled them.
+DOORBELL_MAGIC = int.from_bytes(b'REGIODB\0', 'little')
+DOORBELL_VERSION = 1
+DOORBELL_SUFFIX = '.doorbell'
+DOORBELL_HEAD = 8
+DOORBELL_TAIL = 16
+DOORBELL_ENTRIES = 24
+DOORBELL_ENTRY_WORDS = 4
+DOORBELL_MASK = (1 << 64) - 1
+
+DoorbellEntry = collections.namedtuple('DoorbellEntry', 'kind offset size value clr_mask')
+
+def doorbell_path(name):
+    return SHM_DIR / (name + DOORBELL_SUFFIX)
+
+class Doorbell:
+    def __init__(self, path, depth=None, sync=False, timeout=None):
+        if depth is not None and depth < 1:
+            raise ValueError(f'Doorbell depth {depth} must be at least 1 entry.')
+
+        self.path = pathlib.Path(path)
+        self.depth = depth # Taken from an existing ring when not given.
+        self.sync = sync
+        self.timeout = timeout
+        self.started = False
+
+    def start(self):
+        if self.started:
+            return
+
+        if self.depth is None:
+            nbytes = self.path.stat().st_size
+        else:
+            nbytes = 8 * (DOORBELL_ENTRIES + self.depth * DOORBELL_ENTRY_WORDS)
+        self._io = mmap.FileMmapIO(
+            self.path, nbytes, 64, endian=Endian.LITTLE, release_gil=False)
+        self._io.start()
+
+        # Initialize a newly created ring, storing the magic last. Otherwise, check that the layout
+        # of the existing one matches.
+        io = self._io
+        magic, version, depth = io.read_many((0, 1, 2), 1)
+        if magic == 0 and self.depth is not None:
+            io.write_many(
+                (1, 2, DOORBELL_HEAD, DOORBELL_TAIL), 1, (DOORBELL_VERSION, self.depth, 0, 0),
+                barrier=True)
+            io.write(0, 1, DOORBELL_MAGIC)
+        elif magic != DOORBELL_MAGIC or version != DOORBELL_VERSION:
+            io.stop()
+            raise ValueError(f'{self.path}: Not a doorbell ring of version {DOORBELL_VERSION}.')
+        elif self.depth is not None and depth != self.depth:
+            io.stop()
+            raise ValueError(f'{self.path}: Doorbell depth {depth} doesn\'t match {self.depth}.')
+        self.depth = io.read(2, 1)
+
+        self._head = io.read(DOORBELL_HEAD, 1)
+        self.started = True
+
+    def stop(self):
+        if self.started:
+            self._io.stop()
+            del self._io
+            self.started = False
+
+    def __enter__(self):
+        self.start()
+
+        # Allow caller to bind the object in a 'with X() as x' statement.
+        return self
+
+    def __exit__(self, *pargs):
+        self.stop()
+
+        # Don't suppress exceptions. Pass along to the caller.
+        return False
+
+    def _wait(self, ready, what, timeout):
+        # Spin briefly before yielding the CPU, since the other side is normally quick to respond.
+        deadline = None if timeout is None else time.monotonic() + timeout
+        spins = 0
+        while not ready():
+            spins += 1
+            if spins < 1000:
+                continue
+            if deadline is not None and time.monotonic() >= deadline:
+                raise TimeoutError(f'{self.path}: Timed out after {timeout}s waiting for {what}.')
+            time.sleep(0 if spins < 2000 else 50e-6)
+
+    @property
+    def pending(self):
+        # Number of notifications not yet consumed.
+        return self._io.read(DOORBELL_HEAD, 1) - self._io.read(DOORBELL_TAIL, 1)
+
+    #-----------------------------------------------------------------------------------------------
+    def ring(self, entries):
+        # Produce a notification for each (kind, offset, size, value, clr_mask) entry, storing as
+        # many as there is room for at a time.
+        io = self._io
+        depth = self.depth
+        head = self._head
+        entries = list(entries)
+        while entries:
+            room = depth - (head - io.read(DOORBELL_TAIL, 1))
+            if room <= 0:
+                self._wait(
+                    lambda: head - io.read(DOORBELL_TAIL, 1) < depth, 'room in the ring',
+                    self.timeout)
+                continue
+            batch, entries = entries[:room], entries[room:]
+
+            offsets = []
+            values = []
+            for kind, offset, size, value, clr_mask in batch:
+                i = DOORBELL_ENTRIES + (head % depth) * DOORBELL_ENTRY_WORDS
+                offsets.extend((i, i + 1, i + 2, i + 3))
+                values.extend((
+                    offset, size | (kind << 32), value & DOORBELL_MASK, clr_mask & DOORBELL_MASK))
+                head += 1
+
+            io.write_many(offsets, 1, values, barrier=True)
+            io.write(DOORBELL_HEAD, 1, head)
+            self._head = head
+
+        if self.sync:
+            self._wait(
+                lambda: io.read(DOORBELL_TAIL, 1) >= head, 'the notifications to be consumed',
+                self.timeout)
+
+    def poll(self, limit=None, timeout=0, consume=True):
+        # Fetch up to limit pending notifications, waiting up to timeout seconds (or forever when
+        # None) for at least one. Returns a list of DoorbellEntry objects, oldest first. Unless
+        # consuming them immediately, the entries remain pending until passed to consume.
+        io = self._io
+        depth = self.depth
+        tail = io.read(DOORBELL_TAIL, 1)
+        if timeout != 0:
+            try:
+                self._wait(lambda: io.read(DOORBELL_HEAD, 1) != tail, 'notifications', timeout)
+            except TimeoutError:
+                return []
+
+        count = io.read(DOORBELL_HEAD, 1) - tail
+        if limit is not None:
+            count = min(count, limit)
+        if count <= 0:
+            return []
+
+        offsets = []
+        for n in range(tail, tail + count):
+            i = DOORBELL_ENTRIES + (n % depth) * DOORBELL_ENTRY_WORDS
+            offsets.extend((i, i + 1, i + 2, i + 3))
+        words = io.read_many(offsets, 1)
+        if consume:
+            io.write(DOORBELL_TAIL, 1, tail + count)
+
+        entries = []
+        for i in range(0, len(words), DOORBELL_ENTRY_WORDS):
+            offset, kind_size, value, clr_mask = words[i:i + DOORBELL_ENTRY_WORDS]
+            entries.append(DoorbellEntry(
+                Kind(kind_size >> 32), offset, kind_size & 0xffffffff, value, clr_mask))
+        return entries
+
+    def consume(self, entries):
+        # Release the oldest pending notifications, previously fetched without being consumed.
+        io = self._io
+        io.write(DOORBELL_TAIL, 1, io.read(DOORBELL_TAIL, 1) + len(entries))
+
+#---------------------------------------------------------------------------------------------------
+# Memory mapped IO on a POSIX shared memory file (in /dev/shm), or on a hugetlbfs file (in
+# /dev/hugepages) to reduce TLB misses on large regions. Any number of processes can map the same
+# region by name, for co-simulation with a process serving the registers at memory speed. Reads are
+# served by the shared memory itself, such that the serving process must keep it up to date. When a
+# doorbell depth is given, writes and updates also notify the serving process through a doorbell
+# ring (accesses through exported buffers don't). The serving process maps the region without a
+# doorbell and consumes the ring through a Doorbell of its own (see doorbell_path).
+class ShmIO(mmap.FileMmapIO):
+    def __init__(self, name, file_size, data_width, hugepages=False, doorbell_depth=0,
+                 doorbell_sync=False, timeout=None, *pargs, **kargs):
+        if '/' in name:
+            raise ValueError(f'Shared memory name "{name}" must not contain a "/".')
+
+        # Files on hugetlbfs can only be sized and mapped in multiples of the huge page size.
+        directory = SHM_DIR
+        if hugepages:
+            directory = HUGEPAGES_DIR
+            pagesize = hugepage_size()
+            file_size = (file_size + pagesize - 1) // pagesize * pagesize
+        super().__init__(directory / name, file_size, data_width, *pargs, **kargs)
+
+        self.name = name
+        self.doorbell = None
+        if doorbell_depth > 0:
+            self.doorbell = Doorbell(doorbell_path(name), doorbell_depth, doorbell_sync, timeout)
+
+    def start(self):
+        if not self.started:
+            super().start()
+            if self.doorbell is not None:
+                self.doorbell.start()
+
+    def stop(self):
+        if self.started:
+            if self.doorbell is not None:
+                self.doorbell.stop()
+            super().stop()
+
+    def unlink(self):
+        # Remove the shared memory files, which otherwise persist until reboot. Processes which
+        # still have them mapped are unaffected.
+        self.path.unlink(missing_ok=True)
+        if self.doorbell is not None:
+            self.doorbell.path.unlink(missing_ok=True)
+
+    def write(self, offset, size, value):
+        super().write(offset, size, value)
+        if self.doorbell is not None:
+            self.doorbell.ring(((WRITE, offset, size, value, 0),))
+
+    def update(self, offset, size, clr_mask, set_mask):
+        super().update(offset, size, clr_mask, set_mask)
+        if self.doorbell is not None:
+            self.doorbell.ring(((UPDATE, offset, size, set_mask, clr_mask),))
+
+    # Without the C extension, the batches of the underlying IO are made of calls to write and
+    # update, which would ring the doorbell for each access on top of the batch. Such batches are
+    # instead made of the underlying IO's single accesses, which don't ring.
+    NATIVE_BATCHES = mmap.mmap_ext is not None
+
+    def write_many(self, offsets, sizes, values, barrier=False):
+        if self.NATIVE_BATCHES:
+            super().write_many(offsets, sizes, values, barrier)
+        else:
+            self._write_each(offsets, sizes, values)
+        if self.doorbell is not None:
+            self._ring_many(WRITE, offsets, sizes, values, 0)
+
+    def update_many(self, offsets, sizes, clr_masks, set_masks, barrier=False):
+        if self.NATIVE_BATCHES:
+            super().update_many(offsets, sizes, clr_masks, set_masks, barrier)
+        else:
+            count = len(offsets)
+            update = super().update
+            for offset, size, clr_mask, set_mask in zip(
+                    offsets, self.broadcast('sizes', sizes, count),
+                    self.broadcast('clr_masks', clr_masks, count),
+                    self.broadcast('set_masks', set_masks, count)):
+                update(offset, size, clr_mask, set_mask)
+        if self.doorbell is not None:
+            self._ring_many(UPDATE, offsets, sizes, set_masks, clr_masks)
+
+    def write_combined(self, offsets, sizes, values):
+        if self.NATIVE_BATCHES:
+            super().write_combined(offsets, sizes, values)
+        else:
+            self._write_each(offsets, sizes, values)
+        if self.doorbell is not None:
+            self._ring_many(WRITE, offsets, sizes, values, 0)
+
+    def _write_each(self, offsets, sizes, values):
+        count = len(offsets)
+        write = super().write
+        for offset, size, value in zip(
+                offsets, self.broadcast('sizes', sizes, count),
+                self.broadcast('values', values, count)):
+            write(offset, size, value)
+
+    def _ring_many(self, kind, offsets, sizes, values, clr_masks):
+        # A whole batch is notified at once, after all of its accesses have been made.
+        count = len(offsets)
+        sizes = self.broadcast('sizes', sizes, count)
+        values = self.broadcast('values', values, count)
+        clr_masks = self.broadcast('clr_masks', clr_masks, count)
+        self.doorbell.ring(zip(itertools.repeat(kind), offsets, sizes, values, clr_masks))
+
+#---------------------------------------------------------------------------------------------------
+class ShmIOForSpec(ShmIO):
+    def __init__(self, spec, name, *pargs, **kargs):
+        region = info.region_of(spec)
+        super().__init__(name, region.octets, region.data_width, *pargs, **kargs)
@@ -0,0 +1,432 @@
+#---------------------------------------------------------------------------------------------------
+__all__ = ()
+
+import array
+import enum
+import mmap
+import pathlib
+import struct
+import time
+
+from . import io
+
+#---------------------------------------------------------------------------------------------------
+class Kind(enum.IntEnum):
+    READ = 0
+    WRITE = 1
+    UPDATE = 2
+
+# Plain ints for use on the hot path.
+READ, WRITE, UPDATE = int(Kind.READ), int(Kind.WRITE), int(Kind.UPDATE)
+
+# Latencies are histogrammed into buckets by their bit length in nanoseconds, such that bucket n
+# holds the latencies in the range [2**(n-1), 2**n). Latencies always fit in 64 bits.
+HISTOGRAM_BUCKETS = 65
+
+# Fixed size record of a single access in the trace ring: start time and latency (in nanoseconds),
+# word offset, value (the set mask for updates), access size (in words), kind and flags. Values
+# wider than 64 bits are truncated and flagged.
+RECORD = struct.Struct('<qQQQIBB')
+RECORD_MASK = (1 << 64) - 1
+RECORD_TRUNCATED = 0x1
+
+#---------------------------------------------------------------------------------------------------
+# Trace files hold a complete record of the accesses made on an IO object, for replaying them (see
+# ReplayIO). A file begins with a header (magic and version), followed by a record per access made
+# up of a fixed size part and the value (the set mask for updates) and clear mask (only for updates)
+# as signed little endian ints. The fixed size part holds the start time and latency (in
+# nanoseconds), word offset, access size (in words), kind and the number of bytes in each of the
+# ints. Files of earlier versions, with 32 bit latencies (version 1) or 16 bit byte counts (versions
+# 1 and 2), can still be read.
+TRACE_MAGIC = b'REGIOTR\0'
+TRACE_VERSION = 3
+TRACE_SUFFIX = '.trace'
+TRACE_HEADER = struct.Struct('<8sH')
+TRACE_RECORDS = {
+    1: struct.Struct('<qIQIBHH'),
+    2: struct.Struct('<qQQIBHH'),
+    3: struct.Struct('<qQQIBII'),
+}
+TRACE_RECORD = TRACE_RECORDS[TRACE_VERSION]
+
+def _int_to_bytes(value):
+    return value.to_bytes((value.bit_length() + 8) // 8, 'little', signed=True)
+
+class TraceWriter:
+    def __init__(self, path):
+        self.path = pathlib.Path(path)
+        self._fo = self.path.open('wb')
+        self._fo.write(TRACE_HEADER.pack(TRACE_MAGIC, TRACE_VERSION))
+
+    def write(self, kind, offset, size, value, clr_mask, start, latency):
+        value = _int_to_bytes(value)
+        clr_mask = _int_to_bytes(clr_mask) if kind == UPDATE else b''
+        self._fo.write(TRACE_RECORD.pack(
+            start, latency, offset, size, kind, len(value), len(clr_mask)) + value + clr_mask)
+
+    def flush(self):
+        self._fo.flush()
+
+    def close(self):
+        self._fo.close()
+
+class TraceEntry:
+    __slots__ = ('kind', 'offset', 'size', 'value', 'clr_mask', 'start', 'latency')
+
+    def __init__(self, kind, offset, size, value, clr_mask, start, latency):
+        self.kind = Kind(kind)
+        self.offset = offset
+        self.size = size
+        self.value = value
+        self.clr_mask = clr_mask
+        self.start = start
+        self.latency = latency
+
+    def __str__(self):
+        text = f'{self.kind.name.lower()} of {self.size} words at offset 0x{self.offset:x}'
+        if self.kind is Kind.UPDATE:
+            return text + f' (clear {self.clr_mask:#x}, set {self.value:#x})'
+        if self.kind is Kind.WRITE:
+            return text + f' (value {self.value:#x})'
+        return text
+
+class TraceReader:
+    def __init__(self, path):
+        self.path = pathlib.Path(path)
+        with self.path.open('rb') as fo:
+            try:
+                self._mm = mmap.mmap(fo.fileno(), 0, prot=mmap.PROT_READ)
+            except ValueError: # Empty file.
+                self._mm = b''
+
+        if len(self._mm) < TRACE_HEADER.size:
+            raise ValueError(f'{self.path}: Truncated IO trace.')
+
+        magic, version = TRACE_HEADER.unpack_from(self._mm)
+        if magic != TRACE_MAGIC:
+            raise ValueError(f'{self.path}: Not an IO trace.')
+        self._record = TRACE_RECORDS.get(version)
+        if self._record is None:
+            raise ValueError(f'{self.path}: Unsupported IO trace version {version}.')
+        self.pos = TRACE_HEADER.size
+
+    def close(self):
+        if isinstance(self._mm, mmap.mmap):
+            self._mm.close()
+
+    @property
+    def done(self):
+        return self.pos >= len(self._mm)
+
+    def next(self):
+        # Decode the entry at the current position and advance past it. Returns None at the end.
+        mm = self._mm
+        pos = self.pos
+        if pos >= len(mm):
+            return None
+        record = self._record
+        if pos + record.size > len(mm):
+            raise ValueError(f'{self.path}: Truncated IO trace record at byte {pos}.')
+
+        start, latency, offset, size, kind, nvalue, nclr = record.unpack_from(mm, pos)
+        pos += record.size
+        if pos + nvalue + nclr > len(mm):
+            raise ValueError(f'{self.path}: Truncated IO trace record at byte {self.pos}.')
+
+        value = int.from_bytes(mm[pos:pos + nvalue], 'little', signed=True)
+        pos += nvalue
+        clr_mask = int.from_bytes(mm[pos:pos + nclr], 'little', signed=True) if nclr else 0
+        self.pos = pos + nclr
+        return TraceEntry(kind, offset, size, value, clr_mask, start, latency)
+
+    def __iter__(self):
+        while True:
+            entry = self.next()
+            if entry is None:
+                return
+            yield entry
+
+#---------------------------------------------------------------------------------------------------
+# Instrumentation wrapper around any low-level IO object. Every access is timed and accounted for by
+# word offset, as counts per kind of access, total words, total latency and a latency histogram per
+# kind of access. When a depth is given, every access is also recorded into a preallocated ring of
+# binary records, keeping the most recent ones. Batched accesses are passed through to the wrapped
+# IO as a batch, with the latency being shared equally amongst the accesses.
+#
+# When a path is given, every access is also written out to a trace file, which is created when
+# first started and flushed each time the IO is stopped.
+#
+# The accounting adds a roughly constant overhead to each access, which isn't included in the
+# latencies reported. Statistics are kept in Python containers, so the wrapper must only be used by
+# one thread at a time.
+class TracingIO(io.IO):
+    def __init__(self, llio, depth=0, clock=time.perf_counter_ns, path=None, *pargs, **kargs):
+        super().__init__(*pargs, **kargs)
+
+        self.llio = llio
+        self.depth = depth
+        self.clock = clock
+        self.path = path
+        self._ring = bytearray(RECORD.size * depth) if depth > 0 else None
+        self._writer = None
+        self.clear()
+
+    def __getattr__(self, name):
+        # Expose the attributes of the wrapped IO (such as the data width), so the wrapper can stand
+        # in for it.
+        if name == 'llio':
+            raise AttributeError(name)
+        return getattr(self.llio, name)
+
+    def clear(self):
+        # Per offset lists of the counts, words and latency for each kind of access (indexed by the
+        # kind, offset by 0, 3 and 6 respectively).
+        self.stats = {}
+        self.histograms = tuple(array.array('Q', bytes(8 * HISTOGRAM_BUCKETS)) for _ in Kind)
+        self._head = 0 # Record for the next access.
+        self._count = 0 # Number of valid records.
+
+    def start(self):
+        if self.path is not None and self._writer is None:
+            self._writer = TraceWriter(self.path)
+        self.llio.start()
+        super().start()
+
+    def stop(self):
+        self.llio.stop()
+        if self._writer is not None:
+            self._writer.flush()
+        super().stop()
+
+    #-----------------------------------------------------------------------------------------------
+    def _account(self, kind, offset, size, value, start, latency, clr_mask=0):
+        stats = self.stats
+        entry = stats.get(offset)
+        if entry is None:
+            entry = stats[offset] = [0] * 9
+        entry[kind] += 1
+        entry[kind + 3] += size
+        entry[kind + 6] += latency
+        self.histograms[kind][latency.bit_length()] += 1
+
+        ring = self._ring
+        if ring is not None:
+            head = self._head
+            flags = 0 if value <= RECORD_MASK else RECORD_TRUNCATED
+            RECORD.pack_into(
+                ring, head * RECORD.size,
+                start, offset, value & RECORD_MASK, latency, size, kind, flags)
+            self._head = head + 1 if head + 1 < self.depth else 0
+            if self._count < self.depth:
+                self._count += 1
+
+        if self._writer is not None:
+            self._writer.write(kind, offset, size, value, clr_mask, start, latency)
+
+    def _account_many(self, kind, offsets, sizes, values, start, latency, clr_masks=0):
+        count = len(offsets)
+        if count == 0:
+            return
+
+        latency //= count
+        sizes = self.broadcast('sizes', sizes, count)
+        values = self.broadcast('values', values, count)
+        clr_masks = self.broadcast('clr_masks', clr_masks, count)
+        for offset, size, value, clr_mask in zip(offsets, sizes, values, clr_masks):
+            self._account(kind, offset, size, value, start, latency, clr_mask)
+
+    def read(self, offset, size):
+        clock = self.clock
+        start = clock()
+        value = self.llio.read(offset, size)
+        self._account(READ, offset, size, value, start, clock() - start)
+        return value
+
+    def write(self, offset, size, value):
+        clock = self.clock
+        start = clock()
+        self.llio.write(offset, size, value)
+        self._account(WRITE, offset, size, value, start, clock() - start)
+
+    def update(self, offset, size, clr_mask, set_mask):
+        clock = self.clock
+        start = clock()
+        self.llio.update(offset, size, clr_mask, set_mask)
+        self._account(UPDATE, offset, size, set_mask, start, clock() - start, clr_mask)
+
+    def read_many(self, offsets, sizes, out=None):
+        clock = self.clock
+        start = clock()
+        values = self.llio.read_many(offsets, sizes, out)
+        latency = clock() - start
+
+        # Only the leading items of an out sequence longer than the offsets are filled in.
+        count = len(offsets)
+        results = values if len(values) == count else values[:count]
+        self._account_many(READ, offsets, sizes, results, start, latency)
+        return values
+
+    def write_many(self, offsets, sizes, values, barrier=False):
+        clock = self.clock
+        start = clock()
+        self.llio.write_many(offsets, sizes, values, barrier)
+        self._account_many(WRITE, offsets, sizes, values, start, clock() - start)
+
+    def update_many(self, offsets, sizes, clr_masks, set_masks, barrier=False):
+        clock = self.clock
+        start = clock()
+        self.llio.update_many(offsets, sizes, clr_masks, set_masks, barrier)
+        self._account_many(UPDATE, offsets, sizes, set_masks, start, clock() - start, clr_masks)
+
+    def write_combined(self, offsets, sizes, values):
+        clock = self.clock
+        start = clock()
+        self.llio.write_combined(offsets, sizes, values)
+        self._account_many(WRITE, offsets, sizes, values, start, clock() - start)
+
+    def poll_until(self, offset, size, mask, value, timeout=None, backoff=1e-3):
+        # Polling is accounted as a single read of the final value, lasting for the whole poll.
+        clock = self.clock
+        start = clock()
+        v = self.llio.poll_until(offset, size, mask, value, timeout, backoff)
+        self._account(READ, offset, size, v, start, clock() - start)
+        return v
+
+    #-----------------------------------------------------------------------------------------------
+    def records(self):
+        # Unpack the recorded accesses, oldest first, as tuples in the order of the RECORD fields.
+        first = (self._head - self._count) % self.depth if self.depth > 0 else 0
+        for n in range(self._count):
+            yield RECORD.unpack_from(self._ring, ((first + n) % self.depth) * RECORD.size)
+
+    @property
+    def totals(self):
+        # Per kind of access: count, words and latency.
+        totals = [[0, 0, 0] for _ in Kind]
+        for entry in self.stats.values():
+            for kind, total in enumerate(totals):
+                total[0] += entry[kind]
+                total[1] += entry[kind + 3]
+                total[2] += entry[kind + 6]
+        return totals
+
+    def summary(self, name_of=None, octets=None, limit=None):
+        # Format the statistics as text. Offsets are labelled using the name_of callable when given,
+        # and the sizes are shown in bytes rather than words when the octets per word are given.
+        unit = 'words' if octets is None else 'bytes'
+        scale = 1 if octets is None else octets
+        lines = []
+
+        lines.append(f'{"access":8} {"count":>10} {unit:>12} {"mean ns":>10}')
+        for kind, (count, words, latency) in zip(Kind, self.totals):
+            mean = latency // count if count else 0
+            lines.append(f'{kind.name.lower():8} {count:10d} {words * scale:12d} {mean:10d}')
+
+        for kind, histogram in zip(Kind, self.histograms):
+            if not any(histogram):
+                continue
+
+            lines.append('')
+            lines.append(f'{kind.name.lower()} latency histogram:')
+            for n, count in enumerate(histogram):
+                if count:
+                    lo = (1 << (n - 1)) if n > 0 else 0
+                    lines.append(f'  [{lo:>10d}, {1 << n:>10d}) ns {count:10d}')
+
+        # Offsets are ordered by decreasing number of accesses, to highlight redundant ones.
+        entries = sorted(self.stats.items(), key=lambda item: (-sum(item[1][:3]), item[0]))
+        if limit is not None:
+            entries = entries[:limit]
+        if entries:
+            lines.append('')
+            lines.append(
+                f'{"offset":>10} {"reads":>8} {"writes":>8} {"updates":>8} {unit:>10} '
+                f'{"mean ns":>8}  name')
+            for offset, entry in entries:
+                reads, writes, updates = entry[:3]
+                words = sum(entry[3:6])
+                mean = sum(entry[6:]) // (reads + writes + updates)
+                name = '' if name_of is None else name_of(offset) or ''
+                lines.append(
+                    f'0x{offset * scale:08x} {reads:8d} {writes:8d} {updates:8d} '
+                    f'{words * scale:10d} {mean:8d}  {name}')
+        return '\n'.join(lines)
+
+#---------------------------------------------------------------------------------------------------
+class ReplayError(ValueError): ...
+
+# IO backed by a trace file (as written by TracingIO), for running scripts without any hardware.
+# Accesses must be made in exactly the same sequence as recorded: reads return the recorded values,
+# while writes and updates are checked against the recorded ones. Any divergence raises a
+# ReplayError. When timing is set, each access is delayed until the same time (relative to the first
+# access) as when recorded, otherwise the trace is replayed as fast as possible. The position in the
+# trace is kept when stopped, so replaying continues across restarts.
+class ReplayIO(io.IO):
+    def __init__(self, path, timing=False, clock=time.perf_counter_ns, *pargs, **kargs):
+        super().__init__(*pargs, **kargs)
+
+        self.path = pathlib.Path(path)
+        self.timing = timing
+        self.clock = clock
+        self.count = 0 # Number of accesses replayed.
+        self._pos = None
+        self._done = False
+        self._skew = None # Difference between the replay and recorded clocks.
+
+    def start(self):
+        if not self.started:
+            self._reader = TraceReader(self.path)
+            if self._pos is not None:
+                self._reader.pos = self._pos
+            super().start()
+
+    def stop(self):
+        if self.started:
+            self._pos = self._reader.pos
+            self._done = self._reader.done
+            self._reader.close()
+            del self._reader
+            super().stop()
+
+    @property
+    def done(self):
+        # All recorded accesses have been replayed.
+        return self._reader.done if self.started else self._done
+
+    def _next(self, kind, offset, size):
+        entry = self._reader.next()
+        access = f'{kind.name.lower()} of {size} words at offset 0x{offset:x}'
+        if entry is None:
+            raise ReplayError(
+                f'{self.path}: Trace exhausted after {self.count} accesses on {access}.')
+        if entry.kind is not kind or entry.offset != offset or entry.size != size:
+            raise ReplayError(
+                f'{self.path}: Access #{self.count} is a {access}. Expected the recorded {entry}.')
+
+        if self.timing:
+            now = self.clock()
+            if self._skew is None:
+                self._skew = now - entry.start
+            delay = entry.start + self._skew - now
+            if delay > 0:
+                time.sleep(delay / 1e9)
+
+        self.count += 1
+        return entry
+
+    def read(self, offset, size):
+        return self._next(Kind.READ, offset, size).value
+
+    def write(self, offset, size, value):
+        entry = self._next(Kind.WRITE, offset, size)
+        if entry.value != value:
+            raise ReplayError(
+                f'{self.path}: Access #{self.count - 1} writes {value:#x}. '
+                f'Expected the recorded {entry}.')
+
+    def update(self, offset, size, clr_mask, set_mask):
+        entry = self._next(Kind.UPDATE, offset, size)
+        if entry.value != set_mask or entry.clr_mask != clr_mask:
+            raise ReplayError(
+                f'{self.path}: Access #{self.count - 1} clears {clr_mask:#x} and sets '
+                f'{set_mask:#x}. Expected the recorded {entry}.')
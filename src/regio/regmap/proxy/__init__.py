@@ -1,11 +1,19 @@
 #---------------------------------------------------------------------------------------------------
 __all__ = (
     'ClickEnvironment',
+    'CounterSampler',
     'Environment',
+    'await_for',
     'for_io_by_path',
+    'new_access_plan',
+    'new_counter_sampler',
     'start_io',
     'stop_io',
+    'wait_for',
 )
 
 from .proxy import for_io_by_path, start_io, stop_io
+from .plan import new_access_plan
+from .sampler import CounterSampler, new_counter_sampler
+from .wait import await_for, wait_for
 from .environment import ClickEnvironment, Environment
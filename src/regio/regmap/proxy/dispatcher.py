@@ -15,6 +15,10 @@ def zip_repeat(proxy, value):
             f'Length of values ({len(value)}) must match number of proxies ({nproxies}).')
     return zip(proxy, value)
 
+def zip_read(proxy, value):
+    # Read all proxies in the group as a batch prior to pairing each with it's value.
+    return ((p, r, v) for (p, v), r in zip(zip_repeat(proxy, value), proxy.___read___()))
+
 #---------------------------------------------------------------------------------------------------
 class ForIOCall:
     def __call__(self, *pargs, **kargs):
@@ -34,6 +38,18 @@ class ForIOContextManager:
         # Don't suppress exceptions. Pass along to the caller.
         return False
 
+    async def __aenter__(self):
+        await self.___context___.io.astart()
+
+        # Allow caller to bind the object in an 'async with X() as x' statement.
+        return self
+
+    async def __aexit__(self, *pargs):
+        await self.___context___.io.astop()
+
+        # Don't suppress exceptions. Pass along to the caller.
+        return False
+
 #---------------------------------------------------------------------------------------------------
 class ForIOContextManagerGroup:
     def __enter__(self):
@@ -50,6 +66,20 @@ class ForIOContextManagerGroup:
         # Don't suppress exceptions. Pass along to the caller.
         return False
 
+    async def __aenter__(self):
+        for proxy in self:
+            await proxy.___context___.io.astart()
+
+        # Allow caller to bind the object in an 'async with X() as x' statement.
+        return self
+
+    async def __aexit__(self, *pargs):
+        for proxy in reversed(self):
+            await proxy.___context___.io.astop()
+
+        # Don't suppress exceptions. Pass along to the caller.
+        return False
+
 #---------------------------------------------------------------------------------------------------
 class ForIOSetattr:
     def __setattr__(self, name, value):
@@ -150,14 +180,14 @@ class ForNumericIOFormattingGroup:
 
     def __str__(self):
         return str([
-            '0x{0:0{1}x}'.format(int(proxy), proxy.___node___.region.nibbles)
-            for proxy in self
+            '0x{0:0{1}x}'.format(value, node.region.nibbles)
+            for node, value in zip(self.___chain___, self.___read___())
         ])
 
     def __format__(self, format_spec):
         if not format_spec:
-            return str([str(self) for proxy in self])
-        return str([format_spec.format(int(self)) for proxy in self])
+            return str(self)
+        return str([format_spec.format(value) for value in self.___read___()])
 
 #---------------------------------------------------------------------------------------------------
 # https://docs.python.org/3/reference/datamodel.html#object.__bool__
@@ -181,7 +211,7 @@ class ForNumericIOConversion:
 #---------------------------------------------------------------------------------------------------
 class ForNumericIOConversionGroup:
     def __bool__(self):
-        return all(proxy.___read___() != 0 for proxy in self)
+        return all(value != 0 for value in self.___read___())
 
 #---------------------------------------------------------------------------------------------------
 # https://docs.python.org/3/reference/datamodel.html#object.__round__
@@ -235,22 +265,22 @@ class ForNumericIOComparison:
 #---------------------------------------------------------------------------------------------------
 class ForNumericIOComparisonGroup:
     def __lt__(self, other):
-        return all(proxy.___read___() < other for proxy, other in zip_repeat(self, other))
+        return all(value < other for value, other in zip_repeat(self.___read___(), other))
 
     def __le__(self, other):
-        return all(proxy.___read___() <= other for proxy, other in zip_repeat(self, other))
+        return all(value <= other for value, other in zip_repeat(self.___read___(), other))
 
     def __eq__(self, other):
-        return all(proxy.___read___() == other for proxy, other in zip_repeat(self, other))
+        return all(value == other for value, other in zip_repeat(self.___read___(), other))
 
     def __ne__(self, other):
-        return all(proxy.___read___() != other for proxy, other in zip_repeat(self, other))
+        return all(value != other for value, other in zip_repeat(self.___read___(), other))
 
     def __gt__(self, other):
-        return all(proxy.___read___() > other for proxy, other in zip_repeat(self, other))
+        return all(value > other for value, other in zip_repeat(self.___read___(), other))
 
     def __ge__(self, other):
-        return all(proxy.___read___() >= other for proxy, other in zip_repeat(self, other))
+        return all(value >= other for value, other in zip_repeat(self.___read___(), other))
 
 #---------------------------------------------------------------------------------------------------
 # https://docs.python.org/3/reference/datamodel.html#object.__add__
@@ -298,43 +328,43 @@ class ForNumericIOArithmetic:
 #---------------------------------------------------------------------------------------------------
 class ForNumericIOArithmeticGroup:
     def __add__(self, other):
-        return [proxy.___read___() + other for proxy, other in zip_repeat(self, other)]
+        return [value + other for value, other in zip_repeat(self.___read___(), other)]
 
     def __sub__(self, other):
-        return [proxy.___read___() - other for proxy, other in zip_repeat(self, other)]
+        return [value - other for value, other in zip_repeat(self.___read___(), other)]
 
     def __mul__(self, other):
-        return [proxy.___read___() * other for proxy, other in zip_repeat(self, other)]
+        return [value * other for value, other in zip_repeat(self.___read___(), other)]
 
     def __truediv__(self, other):
-        return [proxy.___read___() / other for proxy, other in zip_repeat(self, other)]
+        return [value / other for value, other in zip_repeat(self.___read___(), other)]
 
     def __floordiv__(self, other):
-        return [proxy.___read___() // other for proxy, other in zip_repeat(self, other)]
+        return [value // other for value, other in zip_repeat(self.___read___(), other)]
 
     def __mod__(self, other):
-        return [proxy.___read___() % other for proxy, other in zip_repeat(self, other)]
+        return [value % other for value, other in zip_repeat(self.___read___(), other)]
 
     def __divmod__(self, other):
-        return [divmod(proxy.___read___(), other) for proxy, other in zip_repeat(self, other)]
+        return [divmod(value, other) for value, other in zip_repeat(self.___read___(), other)]
 
     def __pow__(self, other, modulo=None):
-        return [pow(proxy.___read___(), other, modulo) for proxy, other in zip_repeat(self, other)]
+        return [pow(value, other, modulo) for value, other in zip_repeat(self.___read___(), other)]
 
     def __lshift__(self, other):
-        return [proxy.___read___() << other for proxy, other in zip_repeat(self, other)]
+        return [value << other for value, other in zip_repeat(self.___read___(), other)]
 
     def __rshift__(self, other):
-        return [proxy.___read___() >> other for proxy, other in zip_repeat(self, other)]
+        return [value >> other for value, other in zip_repeat(self.___read___(), other)]
 
     def __and__(self, other):
-        return [proxy.___read___() & other for proxy, other in zip_repeat(self, other)]
+        return [value & other for value, other in zip_repeat(self.___read___(), other)]
 
     def __xor__(self, other):
-        return [proxy.___read___() ^ other for proxy, other in zip_repeat(self, other)]
+        return [value ^ other for value, other in zip_repeat(self.___read___(), other)]
 
     def __or__(self, other):
-        return [proxy.___read___() | other for proxy, other in zip_repeat(self, other)]
+        return [value | other for value, other in zip_repeat(self.___read___(), other)]
 
 #---------------------------------------------------------------------------------------------------
 # https://docs.python.org/3/reference/datamodel.html#object.__radd__
@@ -382,43 +412,43 @@ class ForNumericIOArithmeticReflected:
 #---------------------------------------------------------------------------------------------------
 class ForNumericIOArithmeticReflectedGroup:
     def __radd__(self, other):
-        return [other + proxy.___read___() for proxy, other in zip_repeat(self, other)]
+        return [other + value for value, other in zip_repeat(self.___read___(), other)]
 
     def __rsub__(self, other):
-        return [other - proxy.___read___() for proxy, other in zip_repeat(self, other)]
+        return [other - value for value, other in zip_repeat(self.___read___(), other)]
 
     def __rmul__(self, other):
-        return [other * proxy.___read___() for proxy, other in zip_repeat(self, other)]
+        return [other * value for value, other in zip_repeat(self.___read___(), other)]
 
     def __rtruediv__(self, other):
-        return [other / proxy.___read___() for proxy, other in zip_repeat(self, other)]
+        return [other / value for value, other in zip_repeat(self.___read___(), other)]
 
     def __rfloordiv__(self, other):
-        return [other // proxy.___read___() for proxy, other in zip_repeat(self, other)]
+        return [other // value for value, other in zip_repeat(self.___read___(), other)]
 
     def __rmod__(self, other):
-        return [other % proxy.___read___() for proxy, other in zip_repeat(self, other)]
+        return [other % value for value, other in zip_repeat(self.___read___(), other)]
 
     def __rdivmod__(self, other):
-        return [divmod(other, proxy.___read___()) for proxy, other in zip_repeat(self, other)]
+        return [divmod(other, value) for value, other in zip_repeat(self.___read___(), other)]
 
     def __rpow__(self, other, modulo=None):
-        return [pow(other, proxy.___read___(), modulo) for proxy, other in zip_repeat(self, other)]
+        return [pow(other, value, modulo) for value, other in zip_repeat(self.___read___(), other)]
 
     def __rlshift__(self, other):
-        return [other << proxy.___read___() for proxy, other in zip_repeat(self, other)]
+        return [other << value for value, other in zip_repeat(self.___read___(), other)]
 
     def __rrshift__(self, other):
-        return [other >> proxy.___read___() for proxy, other in zip_repeat(self, other)]
+        return [other >> value for value, other in zip_repeat(self.___read___(), other)]
 
     def __rand__(self, other):
-        return [other & proxy.___read___() for proxy, other in zip_repeat(self, other)]
+        return [other & value for value, other in zip_repeat(self.___read___(), other)]
 
     def __rxor__(self, other):
-        return [other ^ proxy.___read___() for proxy, other in zip_repeat(self, other)]
+        return [other ^ value for value, other in zip_repeat(self.___read___(), other)]
 
     def __ror__(self, other):
-        return [other | proxy.___read___() for proxy, other in zip_repeat(self, other)]
+        return [other | value for value, other in zip_repeat(self.___read___(), other)]
 
 #---------------------------------------------------------------------------------------------------
 # https://docs.python.org/3/reference/datamodel.html#object.__iadd__
@@ -462,52 +492,52 @@ class ForNumericIOArithmeticInPlace:
 #---------------------------------------------------------------------------------------------------
 class ForNumericIOArithmeticInPlaceGroup:
     def __iadd__(self, other):
-        for proxy, other in zip_repeat(self, other):
-            proxy.___write___(proxy.___read___() + other)
+        for proxy, value, other in zip_read(self, other):
+            proxy.___write___(value + other)
 
     def __isub__(self, other):
-        for proxy, other in zip_repeat(self, other):
-            proxy.___write___(proxy.___read___() - other)
+        for proxy, value, other in zip_read(self, other):
+            proxy.___write___(value - other)
 
     def __imul__(self, other):
-        for proxy, other in zip_repeat(self, other):
-            proxy.___write___(proxy.___read___() * other)
+        for proxy, value, other in zip_read(self, other):
+            proxy.___write___(value * other)
 
     def __itruediv__(self, other):
-        for proxy, other in zip_repeat(self, other):
-            proxy.___write___(proxy.___read___() / other)
+        for proxy, value, other in zip_read(self, other):
+            proxy.___write___(value / other)
 
     def __ifloordiv__(self, other):
-        for proxy, other in zip_repeat(self, other):
-            proxy.___write___(proxy.___read___() // other)
+        for proxy, value, other in zip_read(self, other):
+            proxy.___write___(value // other)
 
     def __imod__(self, other):
-        for proxy, other in zip_repeat(self, other):
-            proxy.___write___(proxy.___read___() % other)
+        for proxy, value, other in zip_read(self, other):
+            proxy.___write___(value % other)
 
     def __ipow__(self, other, modulo=None):
-        for proxy, other in zip_repeat(self, other):
-            proxy.___write___(pow(proxy.___read___(), other, modulo))
+        for proxy, value, other in zip_read(self, other):
+            proxy.___write___(pow(value, other, modulo))
 
     def __ilshift__(self, other):
-        for proxy, other in zip_repeat(self, other):
-            proxy.___write___(proxy.___read___() << other)
+        for proxy, value, other in zip_read(self, other):
+            proxy.___write___(value << other)
 
     def __irshift__(self, other):
-        for proxy, other in zip_repeat(self, other):
-            proxy.___write___(proxy.___read___() >> other)
+        for proxy, value, other in zip_read(self, other):
+            proxy.___write___(value >> other)
 
     def __iand__(self, other):
-        for proxy, other in zip_repeat(self, other):
-            proxy.___write___(proxy.___read___() & other)
+        for proxy, value, other in zip_read(self, other):
+            proxy.___write___(value & other)
 
     def __ixor__(self, other):
-        for proxy, other in zip_repeat(self, other):
-            proxy.___write___(proxy.___read___() ^ other)
+        for proxy, value, other in zip_read(self, other):
+            proxy.___write___(value ^ other)
 
     def __ior__(self, other):
-        for proxy, other in zip_repeat(self, other):
-            proxy.___write___(proxy.___read___() | other)
+        for proxy, value, other in zip_read(self, other):
+            proxy.___write___(value | other)
 
 #---------------------------------------------------------------------------------------------------
 # https://docs.python.org/3/reference/datamodel.html#object.__neg__
@@ -527,13 +557,16 @@ class ForNumericIOArithmeticUnary:
 #---------------------------------------------------------------------------------------------------
 class ForNumericIOArithmeticUnaryGroup:
     def __neg__(self):
-        return [-proxy.___read___() for proxy in self]
+        return [-value for value in self.___read___()]
 
     def __pos__(self):
-        return [proxy.___read___() for proxy in self]
+        return self.___read___()
 
     def __invert__(self):
-        return [~proxy.___read___() & proxy.___node___.region.mask for proxy in self]
+        return [
+            ~value & node.region.mask
+            for node, value in zip(self.___chain___, self.___read___())
+        ]
 
 #---------------------------------------------------------------------------------------------------
 class ForNumericIOOperators(
@@ -568,17 +601,35 @@ class ForArrayIO(ForIO, ForIOSetitem, ForIOFormatting): ...
 class ForArrayIOGroup(ForIOGroup, ForIOSetitemGroup, ForIOFormattingGroup): ...
 
 #---------------------------------------------------------------------------------------------------
+# The awaitable variants of reads and writes allow any number of accesses to be in flight at once
+# (as in 'await asyncio.gather(a.___aread___(), b.___aread___())'), when supported by the IO.
 class ForNumericIO(ForIO, ForIOSetattr, ForNumericIOOperators):
     def ___read___(self):
         return self.___context___.io.read_region(self.___node___.region)
 
-class ForNumericIOGroup(ForIOGroup, ForIOSetattrGroup, ForNumericIOOperatorsGroup): ...
+    async def ___aread___(self):
+        return await self.___context___.io.aread_region(self.___node___.region)
+
+class ForNumericIOGroup(ForIOGroup, ForIOSetattrGroup, ForNumericIOOperatorsGroup):
+    # All regions in the group are resolved directly from the chain's nodes (without creating a
+    # proxy for each) and read in a single batched IO operation. The values are returned as a list,
+    # or filled into the given out sequence (such as an array.array or numpy array).
+    def ___read___(self, out=None):
+        return self.___context___.io.read_regions(
+            (node.region for node in self.___chain___), out)
+
+    async def ___aread___(self, out=None):
+        return await self.___context___.io.aread_regions(
+            (node.region for node in self.___chain___), out)
 
 #---------------------------------------------------------------------------------------------------
 class ForRegisterIO(ForNumericIO):
     def ___write___(self, value):
         self.___context___.io.write_region(self.___node___.region, value)
 
+    async def ___awrite___(self, value):
+        await self.___context___.io.awrite_region(self.___node___.region, value)
+
 class ForRegisterIOGroup(ForNumericIOGroup): ...
 
 #---------------------------------------------------------------------------------------------------
@@ -586,4 +637,7 @@ class ForFieldIO(ForNumericIO):
     def ___write___(self, value):
         self.___context___.io.update_region(self.___node___.region, value)
 
+    async def ___awrite___(self, value):
+        await self.___context___.io.aupdate_region(self.___node___.region, value)
+
 class ForFieldIOGroup(ForNumericIOGroup): ...
@@ -3,14 +3,18 @@ __all__ = ()
 
 import code
 import collections
-import importlib, importlib.util
+import concurrent.futures
+import contextlib
+import importlib, importlib.machinery, importlib.util
 import pathlib
 import re
 import sys
 
 import click, click.shell_completion
 
-from . import proxy, variable
+from . import proxy, snapshot, variable
+from ..io import cache, remote, trace
+from ..spec import info
 
 PROXY_TYPES = (proxy.Proxy, variable.Variable)
 
@@ -58,6 +62,19 @@ class Environment:
         self._namespace = vars(self._mod)
         self._variables = collections.OrderedDict()
 
+        # Number of threads used for performing IO on the proxies of different variables (typically
+        # one per device) concurrently. The proxies of a single variable are always accessed by the
+        # same thread, since they may share IO resources.
+        self.jobs = 1
+
+        # When profiling, the IO of every proxy is traced and a summary of the accesses is displayed
+        # (on stderr) each time the environment is stopped.
+        self.profile = False
+
+        # When caching, reads of registers which can be cached (see register.Caching) are served
+        # from a per proxy cache rather than the devices.
+        self.cache = False
+
     def new_variable(self, name):
         if name in self._variables:
             raise NameError(f'The "{name}" environment variable already exists.')
@@ -80,17 +97,82 @@ class Environment:
         # Don't suppress exceptions. Pass along to the caller.
         return False
 
+    def _map(self, func, items):
+        # Apply the function to each item, yielding the results in the order of the items.
+        items = list(items)
+        if self.jobs <= 1 or len(items) <= 1:
+            yield from map(func, items)
+            return
+
+        with concurrent.futures.ThreadPoolExecutor(max_workers=self.jobs) as executor:
+            yield from executor.map(func, items)
+
+    @contextlib.contextmanager
+    def _bind_local_cpus(self, v):
+        # Bind the calling thread to the CPUs local to the devices of a variable (or None) while
+        # accessing them, for the IOs providing them (see MmapIO.bind_local_cpus).
+        with contextlib.ExitStack() as stack:
+            if v is not None:
+                for p in v._proxies.values():
+                    bind = getattr(p.___context___.io, 'bind_local_cpus', None)
+                    if bind is not None:
+                        stack.enter_context(bind())
+            yield
+
     def start(self):
-        # Start all proxies in the environment's namespace.
+        # Interpose tracing and caching on the IO of all proxies. Variables created from the proxies
+        # afterwards (such as for dumping) are buffered on top of them. The cache is on top of the
+        # tracing, so that profiles only include the accesses which reach the devices.
         for v in self._variables.values():
             for p in v._proxies.values():
-                proxy.start_io(p)
+                ctx = p.___context___
+                if self.profile and not isinstance(ctx.io, (cache.CachedIO, trace.TracingIO)):
+                    ctx.io = trace.TracingIO(ctx.io)
+                if self.cache and not isinstance(ctx.io, cache.CachedIO):
+                    ctx.io = cache.CachedIO(ctx.io, p.___node___.spec)
+
+        # Start all proxies in the environment's namespace.
+        def start_variable(v):
+            with self._bind_local_cpus(v):
+                for p in v._proxies.values():
+                    proxy.start_io(p)
+
+        for _ in self._map(start_variable, self._variables.values()):
+            pass
 
     def stop(self):
         # Stop all proxies in the environment's namespace.
-        for v in reversed(self._variables.values()):
-            for p in reversed(v._proxies.values()):
-                proxy.stop_io(p)
+        def stop_variable(v):
+            with self._bind_local_cpus(v):
+                for p in reversed(v._proxies.values()):
+                    proxy.stop_io(p)
+
+        for _ in self._map(stop_variable, reversed(self._variables.values())):
+            pass
+
+        if self.profile:
+            self.print_profile()
+
+    def print_profile(self, file=sys.stderr):
+        # Display and reset the IO statistics gathered since the last time, labelling the offsets
+        # with the names of the registers.
+        for vn, v in self._variables.items():
+            for pn, p in v._proxies.items():
+                tio = p.___context___.io
+                if isinstance(tio, cache.CachedIO):
+                    tio = tio.llio
+                if not isinstance(tio, trace.TracingIO):
+                    continue
+
+                spec = p.___node___.spec
+                def name_of(offset):
+                    node = info.register_at(spec, offset)
+                    return None if node is None else node.qualname
+
+                print(f'IO profile for {vn}.{pn}:', file=file)
+                print(tio.summary(name_of, p.___node___.region.data_width // 8), file=file)
+                print(file=file)
+                tio.clear()
 
     def dump(self, paths):
         if paths:
@@ -100,20 +182,71 @@ class Environment:
             # Select all proxies attached to the environment variables.
             paths = [[vn, pn] for vn, v in self._variables.items() for pn in v._proxies]
 
-        # Perform a verbose dump of the selected proxies.
+        # Group the paths by their leading component (the environment variable), such that all
+        # objects of a variable are dumped by the same thread.
+        groups = collections.OrderedDict()
+        for i, names in enumerate(paths):
+            groups.setdefault(names[0], []).append((i, names))
+
+        def dump_group(group):
+            results = []
+            with self._bind_local_cpus(self._variables.get(group[0][1][0])):
+                for i, names in group:
+                    # Lookup the object.
+                    obj = self._mod
+                    while names:
+                        obj = getattr(obj, names.pop(0))
+
+                    # Render the object.
+                    if isinstance(obj, proxy.Proxy):
+                        obj = obj(...)
+                    results.append((i, str(obj)))
+            return results
+
+        # Perform a verbose dump of the selected proxies, displaying the objects in the order in
+        # which their paths were given.
         with self:
-            for names in paths:
-                # Lookup the object.
-                obj = self._mod
-                while names:
-                    obj = getattr(obj, names.pop(0))
+            pending = {}
+            index = 0
+            for results in self._map(dump_group, groups.values()):
+                pending.update(results)
+                while index in pending:
+                    print(pending.pop(index))
+                    index += 1
+
+    def _named_proxies(self):
+        # All proxies in the environment, named by their path (such as dev0.bar2).
+        return collections.OrderedDict(
+            (f'{vn}.{pn}', p) for vn, v in self._variables.items() for pn, p in v._proxies.items())
+
+    def capture(self):
+        # Read the registers of all proxies into a snapshot, with the proxies of different variables
+        # being read concurrently.
+        def capture_variable(item):
+            vn, v = item
+            with self._bind_local_cpus(v):
+                return [snapshot.Section.capture(f'{vn}.{pn}', p) for pn, p in v._proxies.items()]
+
+        with self:
+            sections = self._map(capture_variable, self._variables.items())
+            return snapshot.Snapshot(s for group in sections for s in group)
+
+    def snapshot(self, path):
+        self.capture().save(path)
 
-                # Display the object.
-                if isinstance(obj, proxy.Proxy):
-                    obj = obj(...)
-                print(obj)
+    def diff(self, old_path, new_path=None, file=None):
+        # Display the registers and fields which differ between a saved snapshot and either another
+        # one or the live registers. Returns the number of differing registers.
+        with snapshot.Snapshot.open(old_path) as old:
+            if new_path is None:
+                return snapshot.print_diff(old, self.capture(), self._named_proxies(), file)
+
+            with snapshot.Snapshot.open(new_path) as new:
+                return snapshot.print_diff(old, new, self._named_proxies(), file)
 
     def eval(self, expressions):
+        # Expressions may access any number of variables and depend on the side-effects of previous
+        # expressions, so are always evaluated in order by the calling thread.
         with self:
             for expr in expressions:
                 # Compile the string into a code object. This is needed because the builtin eval()
@@ -134,6 +267,24 @@ class Environment:
                 if result is not None:
                     print(result)
 
+    def serve(self, address):
+        # Serve the IO of all proxies to remote clients (see RemoteIO) until interrupted, with each
+        # proxy being a target named by its path in the environment (such as dev0.bar2). This saves
+        # clients from having to load the regmaps and map the devices for every query.
+        with self:
+            targets = {
+                f'{vn}.{pn}': (
+                    p.___context___.io, p.___node___.region.data_width, p.___node___.region.size)
+                for vn, v in self._variables.items()
+                for pn, p in v._proxies.items()
+            }
+            with remote.RegisterServer(address, targets) as server:
+                print(f'Serving {", ".join(targets)} on {server.address}.', file=sys.stderr)
+                try:
+                    server.serve_forever()
+                except KeyboardInterrupt:
+                    ...
+
     def script(self, path, argv):
         if not isinstance(path, pathlib.Path):
             path = pathlib.Path(path)
@@ -328,6 +479,34 @@ class ClickEnvironment(Environment):
                 '--column-layout',
                 help='Specify a custom column layout to be used by the table formatter.',
             ),
+            click.option(
+                '-j', '--jobs',
+                help='''
+                Number of threads for performing IO on multiple devices concurrently. Displayed
+                output is always in the same order as for a single thread.
+                ''',
+                type=click.IntRange(min=1),
+                default=1,
+                show_default=True,
+            ),
+            click.option(
+                '--profile',
+                help='''
+                Trace all IO issued to the devices and display a summary of the accesses on stderr,
+                with counts, sizes and latencies per register along with latency histograms.
+                ''',
+                is_flag=True,
+                default=False,
+            ),
+            click.option(
+                '--cache',
+                help='''
+                Cache the values of registers, except those which the devices may change. Constant
+                registers are read once and read-write registers are cached with write-through.
+                ''',
+                is_flag=True,
+                default=False,
+            ),
         )
 
         for opt in reversed(options):
@@ -336,6 +515,9 @@ class ClickEnvironment(Environment):
 
     def process_options(self, kargs):
         kargs = dict(kargs)
+        self.jobs = kargs.pop('jobs')
+        self.profile = kargs.pop('profile')
+        self.cache = kargs.pop('cache')
         if kargs['column_layout'] is None:
             del kargs['column_layout']
         return kargs
@@ -414,6 +596,27 @@ class ClickEnvironment(Environment):
             '''
             self.dump(object_paths)
 
+        @parent.command()
+        @click.argument('path', type=click.Path(dir_okay=False))
+        def snapshot(path):
+            '''
+            Read all registers from the loaded register map specifications and save them as a
+            compact binary snapshot, for comparing later with the diff command.
+            '''
+            self.snapshot(path)
+
+        @parent.command()
+        @click.argument('old-path', type=click.Path(exists=True, dir_okay=False))
+        @click.argument('new-path', type=click.Path(exists=True, dir_okay=False), required=False)
+        def diff(old_path, new_path):
+            '''
+            Display the registers and fields which differ between two snapshots or, when only one
+            is given, between a snapshot and the live registers. Exits with status 1 when any
+            differ.
+            '''
+            if self.diff(old_path, new_path):
+                sys.exit(1)
+
         @parent.command()
         @click.argument('expressions', nargs=-1, shell_complete=self._path_complete)
         def eval(expressions):
@@ -423,6 +626,24 @@ class ClickEnvironment(Environment):
             '''
             self.eval(expressions)
 
+        @parent.command()
+        @click.option(
+            '-l', '--listen',
+            help='''
+            Address to listen on for connections, as "host:port". Any client able to connect can
+            access the devices, so only listen on trusted interfaces.
+            ''',
+            default=f'127.0.0.1:{remote.DEFAULT_PORT}',
+            show_default=True,
+        )
+        def serve(listen):
+            '''
+            Serve the IO of the loaded register map specifications to remote clients, until
+            interrupted. Each client accesses a target named by its environment path (such as
+            dev0.bar2) through a RemoteIO object.
+            '''
+            self.serve(listen)
+
         @parent.command()
         @click.argument('path', type=click.Path(exists=True, dir_okay=False, resolve_path=True))
         @click.argument('arguments', nargs=-1)
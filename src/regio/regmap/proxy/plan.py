@@ -0,0 +1,155 @@
+#---------------------------------------------------------------------------------------------------
+__all__ = ()
+
+import itertools
+import re
+import weakref
+
+from ..spec import register
+
+#---------------------------------------------------------------------------------------------------
+# An access plan is a pre-resolved set of regions to be accessed as a batch directly on the IO of a
+# proxy's context. Routing through the proxies is done only once, when the plan is compiled. Each
+# region is reduced to a flat (offset, size, shift, mask) entry, which is all that's needed to read
+# or write it. Executing the plan issues one batched IO call, regardless of the number of entries.
+class AccessPlan:
+    def __init__(self, io, regions, is_register):
+        self.io = io
+        self.entries = tuple(
+            (region.offset.absolute, region.size, region.shift, region.mask)
+            for region in regions
+        )
+        self.offsets, self.sizes, self.shifts, self.masks = (
+            tuple(column) for column in zip(*self.entries)) if self.entries else ((),) * 4
+
+        # Registers are written in full, while fields are updated to preserve surrounding bits.
+        self.is_register = tuple(is_register)
+
+    def __len__(self):
+        return len(self.entries)
+
+    def read(self, out=None):
+        return self._extract(self.io.read_many(self.offsets, self.sizes), out)
+
+    def _extract(self, values, out):
+        return self.io.fill(out, [(v >> s) & m for v, s, m in zip(values, self.shifts, self.masks)])
+
+    def _batches(self, values):
+        # Consecutive entries of the same kind are batched together, preserving the overall order.
+        # Yields the arguments of a write_many for registers, otherwise those of an update_many.
+        count = len(self.entries)
+        values = self.io.broadcast('values', values, count)
+
+        items = zip(self.entries, self.is_register, values)
+        for is_register, group in itertools.groupby(items, lambda item: item[1]):
+            group = tuple(group)
+            offsets = [entry[0] for entry, _, _ in group]
+            sizes = [entry[1] for entry, _, _ in group]
+            if is_register:
+                yield True, (offsets, sizes, [v & e[3] for e, _, v in group])
+            else:
+                yield False, (
+                    offsets, sizes,
+                    [~(e[3] << e[2]) for e, _, _ in group],
+                    [(v & e[3]) << e[2] for e, _, v in group])
+
+    def write(self, values, barrier=False):
+        io = self.io
+        for is_register, args in self._batches(values):
+            if is_register:
+                io.write_many(*args, barrier)
+            else:
+                io.update_many(*args, barrier)
+
+    # Awaitable variants of read and write, using the awaitable interface of the IO.
+    async def aread(self, out=None):
+        return self._extract(await self.io.aread_many(self.offsets, self.sizes), out)
+
+    async def awrite(self, values, barrier=False):
+        io = self.io
+        for is_register, args in self._batches(values):
+            if is_register:
+                await io.awrite_many(*args, barrier)
+            else:
+                await io.aupdate_many(*args, barrier)
+
+#---------------------------------------------------------------------------------------------------
+def _nodes_of(obj):
+    chain = obj.___chain___
+    if chain.is_group:
+        return tuple(chain)
+    return (obj.___node___,)
+
+def _regions_of(node):
+    # Registers and fields are accessed as themselves. No need to walk past them.
+    if node.region.register is not None:
+        yield node.region, isinstance(node, register.Node)
+        return
+
+    # The node is a container, so access all registers in it's hierarchy.
+    for child in node.children:
+        yield from _regions_of(child)
+
+#---------------------------------------------------------------------------------------------------
+# Path expressions are relative to the proxy they're compiled on, as in 'a.b[1].c' or 'd[0:64,70]'.
+# Indexing accepts integers and slices, as well as slice lists.
+PATH_TOKEN_RE = re.compile(r'\s*(?:\.?\s*([A-Za-z_]\w*)|\[([^\]]*)\])')
+
+def _parse_index(text):
+    def parse_range(text):
+        parts = text.split(':')
+        if len(parts) == 1:
+            return int(parts[0])
+        if len(parts) > 3:
+            raise ValueError(f'Invalid slice {text!r}.')
+        return slice(*(int(part) if part.strip() else None for part in parts))
+
+    ranges = tuple(parse_range(part) for part in text.split(','))
+    return ranges[0] if len(ranges) == 1 else ranges
+
+def resolve_path(obj, path):
+    pos = 0
+    path = path.strip()
+    while pos < len(path):
+        match = PATH_TOKEN_RE.match(path, pos)
+        if match is None or match.end() == pos:
+            raise ValueError(f'Invalid path expression {path!r} at position {pos}.')
+
+        name, index = match.groups()
+        obj = getattr(obj, name) if name is not None else obj[_parse_index(index)]
+        pos = match.end()
+    return obj
+
+#---------------------------------------------------------------------------------------------------
+# Compiled plan entries only depend on the regmap specification, so they're cached per node and
+# path for re-use across compilations (and across IO objects).
+PLAN_CACHE = weakref.WeakKeyDictionary()
+
+def _compile(obj, path):
+    target = obj if path is None else resolve_path(obj, path)
+    return tuple(item for node in _nodes_of(target) for item in _regions_of(node))
+
+def _compile_cached(obj, path):
+    # Groups are arbitrary selections, so are not cached.
+    node = obj.___node___
+    if obj.___chain___.is_group:
+        return _compile(obj, path)
+
+    entries = PLAN_CACHE.setdefault(node, {})
+    key = (node.region, path)
+    items = entries.get(key)
+    if items is None:
+        items = entries[key] = _compile(obj, path)
+    return items
+
+def new_access_plan(obj, *paths):
+    # Compile the proxy objects reachable by each path into a single plan. When no paths are given,
+    # the proxy itself is compiled.
+    items = []
+    for path in (paths or (None,)):
+        items.extend(_compile_cached(obj, path))
+
+    return AccessPlan(
+        obj.___context___.io,
+        (region for region, _ in items),
+        (is_register for _, is_register in items))
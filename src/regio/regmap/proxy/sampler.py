@@ -0,0 +1,173 @@
+#---------------------------------------------------------------------------------------------------
+__all__ = ()
+
+import array
+import threading
+import time
+
+from .plan import new_access_plan
+
+#---------------------------------------------------------------------------------------------------
+# Periodic sampling of a set of counters (registers or fields) into a preallocated ring buffer. Each
+# sample is one batched read of the counters' registers directly into a row of the ring, so taking a
+# sample allocates no Python objects per counter. Field extraction and wraparound handling are left
+# until the samples are queried, using the width of each counter.
+#
+# Deltas between two samples are computed as the sum of the deltas between each pair of adjacent
+# samples in between, each taken modulo the counter's width. This is correct as long as no counter
+# wraps more than once between adjacent samples, which bounds the sampling period.
+class CounterSampler:
+    def __init__(self, plan, depth=1024, clock=time.monotonic_ns):
+        if depth < 2:
+            raise ValueError(f'Depth {depth} must be at least 2 samples.')
+
+        # Samples are read into rows of unsigned 64 bit integers.
+        for offset, size, shift, mask in plan.entries:
+            if shift + mask.bit_length() > 64:
+                raise ValueError(f'Counter at offset 0x{offset:x} is wider than 64 bits.')
+
+        self.plan = plan
+        self.depth = depth
+        self.clock = clock
+
+        # Use buffers for the access vectors, which are converted without creating any objects.
+        self._offsets = array.array('Q', plan.offsets)
+        self._sizes = array.array('Q', plan.sizes)
+
+        n = len(plan)
+        self._ring = array.array('Q', bytes(8 * n * depth))
+        self._rows = tuple(memoryview(self._ring)[i * n:(i + 1) * n] for i in range(depth))
+        self._times = array.array('q', bytes(8 * depth))
+        self._head = 0 # Row for the next sample.
+        self._count = 0 # Number of valid samples.
+
+        # Serializes sampling against queries, for sampling from a background thread.
+        self._lock = threading.Lock()
+        self._thread = None
+        self._stop = threading.Event()
+
+    def __len__(self):
+        return len(self.plan)
+
+    @property
+    def count(self):
+        return self._count
+
+    def clear(self):
+        with self._lock:
+            self._head = 0
+            self._count = 0
+
+    def sample(self):
+        with self._lock:
+            head = self._head
+            self._times[head] = self.clock()
+            self.plan.io.read_many(self._offsets, self._sizes, self._rows[head])
+
+            self._head = (head + 1) % self.depth
+            if self._count < self.depth:
+                self._count += 1
+
+    #-----------------------------------------------------------------------------------------------
+    def run(self, period, count=None):
+        # Take samples every period seconds, until count samples have been taken or stop is called.
+        # Sample times are scheduled relative to the first, such that sleep jitter doesn't drift.
+        self._stop.clear()
+        start = time.monotonic()
+        n = 0
+        while count is None or n < count:
+            self.sample()
+            n += 1
+
+            delay = start + n * period - time.monotonic()
+            if delay > 0 and self._stop.wait(delay):
+                break
+            if self._stop.is_set():
+                break
+
+    def start(self, period):
+        # Sample in a background thread.
+        if self._thread is not None:
+            raise RuntimeError('Sampler is already running.')
+
+        self._stop.clear()
+        self._thread = threading.Thread(target=self.run, args=(period,), daemon=True)
+        self._thread.start()
+
+    def stop(self):
+        self._stop.set()
+        if self._thread is not None:
+            self._thread.join()
+            self._thread = None
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *pargs):
+        self.stop()
+
+        # Don't suppress exceptions. Pass along to the caller.
+        return False
+
+    #-----------------------------------------------------------------------------------------------
+    def _row(self, age):
+        # Index of the row holding the sample taken age samples before the latest one.
+        if age < 0 or age >= self._count:
+            raise IndexError(f'Sample age {age} is out of range [0,{self._count}).')
+        return (self._head - 1 - age) % self.depth
+
+    def _deltas(self, lag, out):
+        rows = [self._rows[self._row(age)] for age in range(lag + 1)]
+        for i, (_, _, shift, mask) in enumerate(self.plan.entries):
+            delta = 0
+            for cur, prev in zip(rows, rows[1:]):
+                delta += (((cur[i] >> shift) & mask) - ((prev[i] >> shift) & mask)) & mask
+            out[i] = delta
+        return out
+
+    def values(self, age=0, out=None):
+        # Counter values of a sample, with age 0 being the latest.
+        with self._lock:
+            row = self._rows[self._row(age)]
+            return self.plan.io.fill(out, [
+                (v >> shift) & mask for v, (_, _, shift, mask) in zip(row, self.plan.entries)])
+
+    def interval(self, lag=1):
+        # Time in seconds between the latest sample and the one lag samples before it.
+        with self._lock:
+            return (self._times[self._row(0)] - self._times[self._row(lag)]) / 1e9
+
+    def deltas(self, lag=1, out=None):
+        # Increments of each counter between the latest sample and the one lag samples before it.
+        with self._lock:
+            self._row(lag)
+            return self._deltas(lag, array.array('Q', bytes(8 * len(self))) if out is None else out)
+
+    def rates(self, lag=1, out=None):
+        # Average increments per second of each counter over the last lag samples.
+        with self._lock:
+            self._row(lag)
+            out = self._deltas(lag, array.array('d', bytes(8 * len(self))) if out is None else out)
+
+            elapsed = (self._times[self._row(0)] - self._times[self._row(lag)]) / 1e9
+            for i in range(len(self)):
+                out[i] = out[i] / elapsed if elapsed > 0 else 0.0
+            return out
+
+    def history(self, index, out=None):
+        # Increments of a single counter between each pair of adjacent samples, oldest first.
+        with self._lock:
+            _, _, shift, mask = self.plan.entries[index]
+            n = max(self._count - 1, 0)
+            out = array.array('Q', bytes(8 * n)) if out is None else out
+            for i, age in enumerate(range(n, 0, -1)):
+                cur = self._rows[self._row(age - 1)][index]
+                prev = self._rows[self._row(age)][index]
+                out[i] = (((cur >> shift) & mask) - ((prev >> shift) & mask)) & mask
+            return out
+
+#---------------------------------------------------------------------------------------------------
+def new_counter_sampler(obj, *paths, depth=1024, clock=time.monotonic_ns):
+    # Compile the counters reachable by each path (or the proxy itself) into a sampler, in the same
+    # manner as for access plans.
+    return CounterSampler(new_access_plan(obj, *paths), depth, clock)
@@ -0,0 +1,291 @@
+#---------------------------------------------------------------------------------------------------
+__all__ = ()
+
+import array
+import bisect
+import json
+import mmap
+import pathlib
+import struct
+import sys
+
+from ..spec import info
+
+#---------------------------------------------------------------------------------------------------
+# Compact binary snapshot of the registers of any number of proxies (such as all devices and BARs
+# of an environment), for comparing against later snapshots or against live hardware without
+# re-reading and re-formatting every register. The file is mmap'ed and compared column by column,
+# such that only the registers which changed are ever decoded.
+#
+# Layout (all integers are little endian):
+#   header:   magic, version, flags (none yet), section count, meta offset, meta size
+#   sections: per proxy, 8 byte aligned columns over all of its registers (in ordinal order):
+#             offsets (u64), sizes in words (u32), index of the first value word (u64), whether the
+#             register was read (u8), and the values as words of the data width
+#   meta:     JSON list describing each section: name, data width, register count, word count and
+#             the file offset of each column
+#
+# Registers which aren't readable are listed with zero valued words, and aren't compared. Snapshots
+# only hold values, so the names of registers and fields are resolved from the regmap specification
+# of the proxies when displaying differences.
+MAGIC = b'REGIOSS\0'
+VERSION = 1
+HEADER = struct.Struct('<8sHHIQQ')
+WORD_FORMATS = {8: 'B', 16: 'H', 32: 'I', 64: 'Q'}
+COLUMNS = (('offsets', 'Q'), ('sizes', 'I'), ('starts', 'Q'), ('valid', 'B'))
+ALIGN = 8
+
+# Columns are compared in blocks of bytes, only looking at the words of blocks which differ.
+COMPARE_BLOCK = 4096
+
+class SnapshotError(Exception): ...
+
+#---------------------------------------------------------------------------------------------------
+class Section:
+    def __init__(self, name, data_width, offsets, sizes, starts, valid, words):
+        if data_width not in WORD_FORMATS:
+            raise SnapshotError(f'Unsupported data width of {data_width} bits for "{name}".')
+
+        self.name = name
+        self.data_width = data_width
+        self.offsets = offsets
+        self.sizes = sizes
+        self.starts = starts
+        self.valid = valid
+        self.words = words
+
+    def __len__(self):
+        return len(self.offsets)
+
+    @classmethod
+    def capture(cls, name, proxy):
+        # Read all readable registers of the proxy with the coalesced loads of a by-value variable.
+        buffer = proxy()._context.io.buffer
+        layout = buffer.layout
+        width = proxy.___node___.region.data_width
+        if width not in WORD_FORMATS:
+            raise SnapshotError(f'Unsupported data width of {width} bits for "{name}".')
+
+        offsets = array.array('Q')
+        sizes = array.array('I')
+        starts = array.array('Q')
+        valid = array.array('B')
+        data = bytearray()
+        octets = width // 8
+        for i, value in enumerate(buffer.values):
+            size = layout.sizes[i]
+            if not size:
+                continue # Hole in the ordinal range.
+
+            offsets.append(layout.offsets[i])
+            sizes.append(size)
+            starts.append(len(data) // octets)
+            valid.append(value is not None)
+            data += (0 if value is None else value).to_bytes(size * octets, 'little')
+
+        words = array.array(WORD_FORMATS[width])
+        words.frombytes(data)
+        return cls(name, width, offsets, sizes, starts, valid, _native(words))
+
+    def value(self, i):
+        if not self.valid[i]:
+            return None
+
+        start = self.starts[i]
+        words = self.words[start:start + self.sizes[i]]
+        value = 0
+        for word in reversed(words):
+            value = (value << self.data_width) | word
+        return value
+
+    def same_layout(self, other):
+        return (
+            self.data_width == other.data_width and
+            memoryview(self.offsets).tobytes() == memoryview(other.offsets).tobytes() and
+            memoryview(self.sizes).tobytes() == memoryview(other.sizes).tobytes())
+
+    def changed(self, other):
+        # Yield the index of each register whose value differs from that of the other section, in
+        # order. Registers read by only one of the sections are considered changed.
+        if not self.same_layout(other):
+            raise SnapshotError(f'Register layout of "{self.name}" differs between snapshots.')
+
+        changed = set(_diff_items(self.valid, other.valid))
+        starts = self.starts
+        for w in _diff_items(self.words, other.words):
+            changed.add(bisect.bisect_right(starts, w) - 1)
+
+        for i in sorted(changed):
+            if self.valid[i] or other.valid[i]:
+                yield i
+
+def _native(column):
+    # Columns are held in host byte order, but stored as little endian. Only big endian hosts need
+    # to swap them (to and from the file), at the cost of a copy.
+    if sys.byteorder == 'little' or column.itemsize == 1:
+        return column
+    fmt = column.format if isinstance(column, memoryview) else column.typecode
+    column = array.array(fmt, column)
+    column.byteswap()
+    return column
+
+def _diff_items(a, b):
+    # Indices of the items which differ between two equally long memoryviews (or arrays).
+    a = memoryview(a)
+    b = memoryview(b)
+    itemsize = a.itemsize
+    step = max(1, COMPARE_BLOCK // itemsize)
+    for first in range(0, len(a), step):
+        last = min(first + step, len(a))
+        if a[first:last] != b[first:last]:
+            for i in range(first, last):
+                if a[i] != b[i]:
+                    yield i
+
+#---------------------------------------------------------------------------------------------------
+class Snapshot:
+    def __init__(self, sections=()):
+        self.sections = dict((section.name, section) for section in sections)
+        self._mm = None
+
+    @classmethod
+    def capture(cls, proxies):
+        # Capture a snapshot from a mapping of names to started proxies.
+        return cls(Section.capture(name, proxy) for name, proxy in proxies.items())
+
+    def save(self, path):
+        # Lay out the columns of each section, then write them out followed by the meta record.
+        path = pathlib.Path(path)
+        meta = []
+        chunks = []
+        pos = HEADER.size
+        for section in self.sections.values():
+            entry = {
+                'name': section.name,
+                'data_width': section.data_width,
+                'count': len(section),
+                'words': len(section.words),
+            }
+            for key, _ in COLUMNS + (('words', None),):
+                data = memoryview(_native(getattr(section, key))).cast('B')
+                pad = -pos % ALIGN
+                chunks.append(bytes(pad))
+                chunks.append(data)
+                entry[key + '_offset'] = pos + pad
+                pos += pad + len(data)
+            meta.append(entry)
+
+        meta_data = json.dumps(meta, separators=(',', ':')).encode()
+        with path.open('wb') as fo:
+            fo.write(HEADER.pack(MAGIC, VERSION, 0, len(meta), pos, len(meta_data)))
+            for chunk in chunks:
+                fo.write(chunk)
+            fo.write(meta_data)
+
+    @classmethod
+    def open(cls, path):
+        # Map a saved snapshot, with the columns of each section being views into the mapping.
+        path = pathlib.Path(path)
+        with path.open('rb') as fo:
+            mm = mmap.mmap(fo.fileno(), 0, access=mmap.ACCESS_READ)
+
+        try:
+            magic, version, _, count, meta_offset, meta_size = HEADER.unpack_from(mm)
+        except struct.error:
+            mm.close()
+            raise SnapshotError(f'{path}: Truncated register snapshot.') from None
+        if magic != MAGIC or version != VERSION:
+            mm.close()
+            raise SnapshotError(f'{path}: Not a register snapshot of version {VERSION}.')
+
+        view = memoryview(mm)
+        sections = []
+        for entry in json.loads(mm[meta_offset:meta_offset + meta_size]):
+            fmt = WORD_FORMATS.get(entry['data_width'])
+            if fmt is None:
+                view.release()
+                mm.close()
+                width = entry['data_width']
+                raise SnapshotError(f'{path}: Unsupported data width of {width} bits.')
+
+            columns = {}
+            for key, cfmt in COLUMNS + (('words', fmt),):
+                n = entry['words' if key == 'words' else 'count']
+                start = entry[key + '_offset']
+                itemsize = struct.calcsize(cfmt)
+                columns[key] = _native(view[start:start + n * itemsize].cast(cfmt))
+            sections.append(Section(entry['name'], entry['data_width'], **columns))
+
+        snapshot = cls(sections)
+        snapshot._mm = mm
+        return snapshot
+
+    def close(self):
+        # Release the views into the mapping before closing it.
+        if self._mm is not None:
+            for section in self.sections.values():
+                for key, _ in COLUMNS + (('words', None),):
+                    column = getattr(section, key)
+                    if isinstance(column, memoryview):
+                        column.release()
+            self.sections.clear()
+            self._mm.close()
+            self._mm = None
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *pargs):
+        self.close()
+
+        # Don't suppress exceptions. Pass along to the caller.
+        return False
+
+#---------------------------------------------------------------------------------------------------
+# Differences between the registers of the sections in two snapshots, yielded as tuples of (section
+# name, register offset, register size, old value, new value). Values are None for registers which
+# weren't read in a snapshot. Sections missing from either snapshot are skipped.
+def diff(old, new):
+    for name, section in old.sections.items():
+        other = new.sections.get(name)
+        if other is None:
+            continue
+
+        for i in section.changed(other):
+            yield name, section.offsets[i], section.sizes[i], section.value(i), other.value(i)
+
+# Format the differences between two snapshots, naming the registers and the fields which changed
+# by looking them up in the regmap specification of the proxy for each section. Returns the number
+# of differing registers.
+def print_diff(old, new, proxies, file=None):
+    count = 0
+    for name, offset, size, old_value, new_value in diff(old, new):
+        count += 1
+        p = proxies.get(name)
+        node = None if p is None else info.register_at(p.___node___.spec, offset)
+        if node is None:
+            print(f'{name}@0x{offset:x}: {_hex(old_value)} -> {_hex(new_value)}', file=file)
+            continue
+
+        region = node.region
+        start = len(p.___node___.path)
+        octets = region.data_width // 8
+        print(
+            f'{name}.{node.qualname_from(start)} [0x{offset * octets:x}]: '
+            f'{_hex(old_value, region.nibbles)} -> {_hex(new_value, region.nibbles)}', file=file)
+        if old_value is None or new_value is None:
+            continue
+
+        for child in node.children:
+            cregion = child.region
+            shift = (cregion.offset.absolute - offset) * cregion.data_width + cregion.shift
+            a = (old_value >> shift) & cregion.mask
+            b = (new_value >> shift) & cregion.mask
+            if a != b:
+                print(
+                    f'    .{child.name}: {_hex(a, cregion.nibbles)} -> {_hex(b, cregion.nibbles)}',
+                    file=file)
+    return count
+
+def _hex(value, nibbles=1):
+    return '-' if value is None else f'0x{value:0{nibbles}x}'
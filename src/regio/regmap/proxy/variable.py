@@ -1,9 +1,25 @@
 #---------------------------------------------------------------------------------------------------
 __all__ = ()
 
+import weakref
+
 from ..io import io
 from ..spec import address, array, register, structure, union
 
+#---------------------------------------------------------------------------------------------------
+# The register layout and load plan for a node only depend on the regmap specification, so they're
+# computed once on first use and then shared by all variables created on the node.
+class RegisterInfo:
+    def __init__(self, registers):
+        registers = tuple(registers)
+        self.layout = io.RegisterLayout(
+            (node.region for node in registers),
+            (node.region for node in registers if node.config.is_ordered))
+        self.plan = self.layout.plan(
+            node.region for node in registers if node.config.access.is_readable)
+
+REGISTER_INFO = weakref.WeakKeyDictionary()
+
 #---------------------------------------------------------------------------------------------------
 class Variable:
     def __init__(self, node, ctx, chain, initializer=None, *pargs, **kargs):
@@ -21,12 +37,14 @@ class Variable:
             self._context = ctx
         else:
             # By value.
-            # If the context is already buffered, pull-out it's low-level IO for the buffering.
-            # TODO: Should be able to use a custom buffer based on array.array(), where the index
-            #       is the register ordinal, adjusted for the first register in the sub-tree (all
-            #       registers in the sub-tree will be in a contiguous ordinal range).
+            # If the context is already buffered, pull-out it's low-level IO for the buffering. The
+            # buffer is indexed by the register ordinal, adjusted for the first register in the
+            # sub-tree (all registers in the sub-tree will be in a contiguous ordinal range).
             llio = ctx.io.llio if isinstance(ctx.io, io.BufferedIO) else ctx.io
-            self._context = ctx.copy(io.BufferedIO(llio))
+            self._info = self._register_info()
+            # Syncs combine writes to adjacent registers when requested by the 'combine' option.
+            combine = self._kargs.get('combine', ctx.kargs.get('combine', False))
+            self._context = ctx.copy(io.RegisterBufferedIO(llio, self._info.layout, combine))
             self.load(initializer)
 
         # Setup a proxy for the variable on the initialized context.
@@ -43,30 +61,43 @@ class Variable:
         if initializer is not None:
             raise ValueError(f'Unknown initializer {initializer!r}. Must be None or an int.')
 
-        # The variable was created on a singular node, load all registers in it's hierarchy.
-        if not self._chain.is_group:
-            self._load_node(self._node)
-            return
-
-        # The variable was created on a node group, load all registers in the hierarchy of every
-        # node in the group.
-        for node in self._chain:
-            self._load_node(node)
-
-    def _load_node(self, node):
-        # Perform low-level IO to read all registers.
-        load_region = self._context.io.load_region
-
-        # The node is itself a register.
-        if node.region.register is not None:
-            load_region(node.region)
+        # Load all readable registers in the hierarchy of the node or, when the variable was created
+        # on a node group, in the hierarchy of every node in the group. The registers are visited
+        # in ordinal order, allowing for the adjacent ones to be coalesced into ranged loads.
+        # Non-readable registers are skipped, but will still be read upon first access (such as
+        # when formatting with access checks ignored).
+        self._context.io.load_plan(self._info.plan)
+
+    def _register_info(self):
+        # Node groups are arbitrary selections, so are not cached.
+        if self._chain.is_group:
+            return RegisterInfo(
+                rnode for node in self._chain for rnode in self._node_registers(node))
+
+        # Re-compute when the node's region has changed (such as the spec being recounted).
+        node = self._node
+        entry = REGISTER_INFO.get(node)
+        if entry is None or entry[0] is not node.region:
+            entry = (node.region, RegisterInfo(self._node_registers(node)))
+            REGISTER_INFO[node] = entry
+        return entry[1]
+
+    @classmethod
+    def _node_registers(cls, node):
+        # A field is buffered as part of the register containing it.
+        if node.region.register is not None and not isinstance(node, register.Node):
+            for node in node.ancestors:
+                if isinstance(node, register.Node):
+                    break
+
+        # The node is itself a register. No need to walk past it.
+        if isinstance(node, register.Node):
+            yield node
             return
 
-        # The node is a container, so load all registers in it's hierarchy.
-        # TODO: Don't walk the whole sub-tree. No need to walk past a register node.
-        for child in node.descendants:
-            if child.region.register is not None:
-                load_region(child.region)
+        # The node is a container, so find all registers in it's hierarchy.
+        for child in node.children:
+            yield from cls._node_registers(child)
 
     def store(self, initializer=None):
         # Write all buffered data.
@@ -221,6 +252,15 @@ class Formatter:
         ctx = self.var._context
         chain = self.var._chain
 
+        # Format from a read-once snapshot of all registers in the variable's hierarchy. A variable
+        # created by reference would otherwise read a register once for itself and once again for
+        # each of it's fields, which is both slow and clobbers registers with read side-effects.
+        # Non-readable registers are only read (once) when access checks are ignored.
+        if not isinstance(ctx.io, io.RegisterBufferedIO):
+            info = self.var._register_info()
+            ctx = ctx.copy(io.RegisterBufferedIO(ctx.io, info.layout))
+            ctx.io.load_plan(info.plan)
+
         # Determine the set of nodes to be formatted.
         # - If the variable was created on a node group, iterate over all nodes in the router chain.
         # - If the variable was created on a singular node, use it.
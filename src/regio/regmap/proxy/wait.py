@@ -0,0 +1,57 @@
+#---------------------------------------------------------------------------------------------------
+__all__ = ()
+
+#---------------------------------------------------------------------------------------------------
+def _region_of(obj):
+    if obj.___chain___.is_group:
+        raise TypeError('Can only wait on a single register or field, not on a group.')
+
+    region = obj.___node___.region
+    if region.register is None:
+        raise TypeError(f'Can only wait on a register or field, not on {obj!r}.')
+    return region
+
+def _condition_of(obj, value, fields):
+    # Reduce the condition to the (offset, size, mask, value) arguments of a poll_until, where the
+    # mask and value are aligned to the register containing the region. A field waits for the given
+    # value, or for all of its bits to be set by default. Named fields of a register each wait for
+    # their own value, all at once.
+    region = _region_of(obj)
+    if fields:
+        if value is not None:
+            raise ValueError('Can\'t wait for both a register value and field values.')
+
+        mask = 0
+        value = 0
+        for name, field_value in fields.items():
+            # Field shifts are relative to the word containing the field, which can follow the
+            # first word of a multi-word register.
+            field = _region_of(getattr(obj, name))
+            words = field.offset.absolute - region.offset.absolute
+            shift = words * field.data_width + field.shift
+            mask |= field.mask << shift
+            value |= (field_value & field.mask) << shift
+    else:
+        if value is None:
+            value = region.mask
+        mask = region.mask << region.shift
+        value = (value & region.mask) << region.shift
+    return region, mask, value
+
+# Wait for a register or field to read as a value, polling it directly on the IO of the proxy's
+# context. Returns the last value read from the register or field. Raises a TimeoutError if timeout
+# seconds (never when None) elapse first. Examples:
+#   wait_for(dev.bar2.syscfg.status.done)
+#   wait_for(dev.bar2.syscfg.status, ready=1, error=0, timeout=1)
+def wait_for(obj, value=None, timeout=None, backoff=1e-3, **fields):
+    region, mask, value = _condition_of(obj, value, fields)
+    v = obj.___context___.io.poll_until(
+        region.offset.absolute, region.size, mask, value, timeout, backoff)
+    return (v >> region.shift) & region.mask
+
+# Awaitable variant of wait_for, using the awaitable interface of the IO.
+async def await_for(obj, value=None, timeout=None, backoff=1e-3, **fields):
+    region, mask, value = _condition_of(obj, value, fields)
+    v = await obj.___context___.io.apoll_until(
+        region.offset.absolute, region.size, mask, value, timeout, backoff)
+    return (v >> region.shift) & region.mask
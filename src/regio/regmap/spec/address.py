@@ -44,6 +44,8 @@ class Node(tree.Node):
         #             outer region. However, the objects within the inner region will be included
         #             when assigning object IDs and ordinals to give the appearance of continuity.
 
+        region.domain.spaces += 1
+
         # Mark the inner region's beginning and change the data word width. This may result in a
         # re-alignment of the outer region to a joint word boundary. This ensures that the outer
         # region ends on a boundary of it's own, while the inner region starts on a boundary that
@@ -1,7 +1,10 @@
 #---------------------------------------------------------------------------------------------------
 __all__ = ()
 
-from . import meta, structure, tree
+import collections.abc
+import threading
+
+from . import counting, meta, structure, tree
 from ..types import config, indexing
 
 #---------------------------------------------------------------------------------------------------
@@ -20,6 +23,49 @@ class Config(config.Config):
     element_pad = config.PositiveInt(0)
     element_pad_to = config.PositiveInt(0)
 
+#---------------------------------------------------------------------------------------------------
+# Elements of an array are only instantiated when first accessed, rather than all up front. Large
+# arrays would otherwise cost the time and memory of every element's sub-tree, even though most are
+# typically never accessed. Instantiation is serialized by a lock, since a specification may be
+# shared by proxies accessed from different threads (such as for the same BAR of multiple devices).
+# The lock is re-entrant since deriving an element's layout can instantiate elements of other
+# arrays.
+ELEMENTS_LOCK = threading.RLock()
+
+class Elements(collections.abc.Sequence):
+    def __init__(self, node):
+        self.node = node
+        self.nodes = {}
+
+    def __len__(self):
+        return self.node.indexer.length
+
+    def __getitem__(self, ordinal):
+        if isinstance(ordinal, slice):
+            return [self[i] for i in range(*ordinal.indices(len(self)))]
+
+        count = len(self)
+        if ordinal < 0:
+            ordinal += count
+        if ordinal < 0 or ordinal >= count:
+            raise IndexError(f'Element ordinal {ordinal} is out of range [0,{count}).')
+
+        node = self.nodes.get(ordinal)
+        if node is None:
+            with ELEMENTS_LOCK:
+                node = self.nodes.get(ordinal)
+                if node is None:
+                    node = self.node.new_element(ordinal)
+        return node
+
+    def append(self, node):
+        # Called when linking a newly instantiated element into the tree. Nothing to do, since the
+        # element is only published once its layout has been derived (see Node.new_element).
+        pass
+
+    def remove(self, node):
+        raise NotImplementedError
+
 #---------------------------------------------------------------------------------------------------
 # Meta-data attached to instances.
 class Node(tree.Node):
@@ -28,11 +74,44 @@ class Node(tree.Node):
         # in the manner of C-style arrays.
         self.indexer = indexing.CArrayIndexer(self.config.dimensions)
 
-        # Instantiate each element in the array. The resulting nodes will be added as children
-        # according to the ordering dictated by the indexer (as a flattened C-style array).
+        # The elements are added as children according to the ordering dictated by the indexer (as a
+        # flattened C-style array), but are only instantiated on demand.
+        self.children = Elements(self)
+
+        # Once counted, the layout of the elements is described either by a stride between them, or
+        # by a reference array with an identical layout (when the array is itself within a displaced
+        # sub-tree).
+        self.stride = None
+        self.reference = None
+
+    def new_element(self, ordinal):
+        # Instantiate the element, which links it into the tree as a child.
+        index = self.indexer.from_ordinal(ordinal)
         data = meta.data_get(type(self.spec))
-        for index in self.indexer:
-            data.element_cls(''.join(f'[{i}]' for i in index), self.spec, index)
+        node = meta.data_get(data.element_cls(''.join(f'[{i}]' for i in index), self.spec, index))
+
+        # Derive the element's layout once the array has been counted. Only then is the element
+        # published, such that lookups never find an element without a layout.
+        self.displace_element(ordinal, node)
+        self.children.nodes[ordinal] = node
+        return node
+
+    def displace_element(self, ordinal, node):
+        if self.reference is not None:
+            source, displacement = self.reference
+            node.displace(source.children[ordinal], displacement, False)
+        elif self.stride is not None and ordinal > 0:
+            words, ordinals, registers = self.stride
+            node.displace(self.children[0], counting.Displacement(
+                words * ordinal, ordinals * ordinal, registers * ordinal,
+                ((len(self.region.oid), ordinal),)))
+
+    def displace(self, source, displacement, root=True):
+        # The elements are derived from those of the source array, using the same displacement.
+        self.region = displacement.apply(source.region, root)
+        self.reference = (source, displacement)
+        for ordinal, node in tuple(self.children.nodes.items()):
+            self.displace_element(ordinal, node)
 
     def init_region(self, region):
         # Set the base offset in the outer region.
@@ -45,9 +124,33 @@ class Node(tree.Node):
         # Mark the inner region's beginning.
         region.begin()
 
-        # Add sub-regions for the array elements.
-        for node in self.children:
-            region.add(node)
+        # Add sub-regions for the array elements. The first element is always counted in full.
+        count = len(self.children)
+        if count > 0:
+            domain = region.domain
+            ordinal, register, spaces = domain.ordinal, domain.register, domain.spaces
+            first = self.children[0]
+            region.add(first)
+
+            if domain.spaces == spaces:
+                # Counting within a region is relative to it's beginning, so every element has the
+                # same layout as the first, only displaced by a fixed stride. The remaining elements
+                # are accounted for by arithmetic and their regions derived when first accessed.
+                size = region.size
+                stride = size + (-size % first.config.align) - first.region.offset.relative
+                self.stride = (stride, domain.ordinal - ordinal, domain.register - register)
+
+                region.inc(stride * (count - 1))
+                domain.ordinal += self.stride[1] * (count - 1)
+                domain.register += self.stride[2] * (count - 1)
+
+                # Elements instantiated prior to counting need their layouts derived.
+                for ordinal, node in tuple(self.children.nodes.items()):
+                    self.displace_element(ordinal, node)
+            else:
+                # The elements contain address spaces, so they must all be counted in full.
+                for ordinal in range(1, count):
+                    region.add(self.children[ordinal])
 
         # Pad out the inner region. Note that this is only padding the end of the entire array.
         region.inc(self.config.pad)
@@ -1,6 +1,7 @@
 #---------------------------------------------------------------------------------------------------
 __all__ = ()
 
+import copy
 import math
 
 from . import meta
@@ -17,6 +18,38 @@ class RegionInfo:
         self.ordinal = None
         self.register = None
 
+#---------------------------------------------------------------------------------------------------
+# Displacement between two sub-trees with identical layouts, such as the elements of an array. The
+# region of a node in one sub-tree is derived from the region of the corresponding node in the other
+# by shifting the offsets, ordinals and register indices, as well as replacing the components of the
+# object ID at the given depths. Only the root of the sub-tree moves relative to its parent region.
+class Displacement:
+    def __init__(self, words=0, ordinals=0, registers=0, oids=()):
+        self.words = words
+        self.ordinals = ordinals
+        self.registers = registers
+        self.oids = oids # Sequence of (depth, component) pairs.
+
+    def apply(self, info, root=False):
+        new = copy.copy(info)
+        new.offset = counter.Value(
+            info.offset.relative + (self.words if root else 0), info.offset.absolute + self.words)
+        if hasattr(info, 'base'):
+            base = info.base
+            new.base = new.offset if base is info.offset else \
+                counter.Value(base.relative, base.absolute + self.words)
+
+        new.ordinal += self.ordinals
+        if info.register is not None:
+            new.register += self.registers
+
+        if self.oids:
+            oid = list(info.oid)
+            for depth, component in self.oids:
+                oid[depth] = component
+            new.oid = tuple(oid)
+        return new
+
 #---------------------------------------------------------------------------------------------------
 class Region:
     def __init__(self, domain, parent, node):
@@ -182,6 +215,10 @@ class Domain:
         self.ordinal = 0
         self.register = 0
 
+        # Number of address spaces counted so far. Their layout depends on the data word widths of
+        # the enclosing regions, so sub-trees containing them can't be derived by displacement.
+        self.spaces = 0
+
         # Note: This loop should not be condensed into a comprehension due to the length being used
         # for accounting purposes by the regions during iteration.
         self.regions = []
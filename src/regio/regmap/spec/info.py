@@ -8,12 +8,13 @@ __all__ = (
     'oid_of',
     'ordinal_of',
     'region_of',
+    'register_at',
     'size_of',
 )
 
 import collections.abc
 
-from . import meta
+from . import array, meta
 
 #---------------------------------------------------------------------------------------------------
 def _node_from_index(spec, index):
@@ -62,3 +63,32 @@ def ordinal_of(spec, index=None):
 # In data words.
 def size_of(spec, index=None):
     return region_of(spec, index).size
+
+#---------------------------------------------------------------------------------------------------
+# Lookup the register node containing a word offset, or None if there isn't one. The elements of an
+# array are laid out in order of increasing offset, so are searched by bisection rather than every
+# element being instantiated.
+def register_at(spec, offset):
+    node = meta.data_get(spec)
+    while node.region.register is None:
+        children = node.children
+        if isinstance(node, array.Node):
+            # Find the last element starting at or before the offset. The bisect module's key
+            # argument requires Python 3.10, so the search is done by hand.
+            lo, hi = 0, len(children)
+            while lo < hi:
+                mid = (lo + hi) // 2
+                if children[mid].region.offset.absolute <= offset:
+                    lo = mid + 1
+                else:
+                    hi = mid
+            children = children[lo - 1:lo] if lo > 0 else ()
+
+        for child in children:
+            region = child.region
+            if region.offset.absolute <= offset < region.offset.absolute + region.size:
+                node = child
+                break
+        else:
+            return None
+    return node
@@ -6,6 +6,16 @@ import enum
 from . import field, meta, tree
 from ..types import config
 
+#---------------------------------------------------------------------------------------------------
+# How values read from a register may be cached by IO (see CachedIO):
+# - NONE: Always accessed, since the device may change the value at any time.
+# - WRITE_THROUGH: Cached once read or written, with writes always passed on to the device.
+# - CONSTANT: Cached once read, since the value never changes after reset (such as build info).
+class Caching(enum.Enum):
+    NONE = enum.auto()
+    WRITE_THROUGH = enum.auto()
+    CONSTANT = enum.auto()
+
 #---------------------------------------------------------------------------------------------------
 class Config(config.Config):
     access = config.EnumFromStr(field.Access, 'RW')
@@ -13,9 +23,37 @@ class Config(config.Config):
     offset = config.PositiveInt(0)
     size = config.PositiveInt(1)
 
+    # Writes have ordering sensitive side-effects (such as a doorbell), so must never be combined
+    # with the writes to other registers. Implied for write event registers.
+    ordered = config.Bool(False)
+
+    @property
+    def is_ordered(self):
+        return self.ordered or self.access is field.Access.WR_EVT
+
+    # The value never changes after reset, so can be cached indefinitely.
+    constant = config.Bool(False)
+
+    # The device may change the value of a read-write register (such as a counter with a writeable
+    # reset value), so it must never be cached.
+    volatile = config.Bool(False)
+
 #---------------------------------------------------------------------------------------------------
 # Meta-data attached to instances.
 class Node(tree.Node):
+    @property
+    def caching(self):
+        # Only registers that are read-write throughout can have their writes cached, since the
+        # device owns the value of any other bits.
+        cfg = self.config
+        if cfg.constant:
+            return Caching.CONSTANT
+        if cfg.volatile or cfg.access is not field.Access.RW:
+            return Caching.NONE
+        if any(child.config.access is not field.Access.RW for child in self.children):
+            return Caching.NONE
+        return Caching.WRITE_THROUGH
+
     def init_region(self, region):
         # A register can only be defined within a word counting region.
         if not region.in_words:
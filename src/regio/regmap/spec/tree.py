@@ -57,3 +57,9 @@ class Node(Base):
     def members_init(self):
         self.members = tuple(m(m.name, self.spec) for m in self.members)
         self.members_map = dict((m.name, m) for m in self.members)
+
+    def displace(self, source, displacement, root=True):
+        # Derive the regions of the sub-tree from those of a source sub-tree with identical layout.
+        self.region = displacement.apply(source.region, root)
+        for node, snode in zip(self.children, source.children):
+            node.displace(snode, displacement, False)
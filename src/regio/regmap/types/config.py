@@ -157,6 +157,13 @@ class EnumFromStr(Descriptor):
         self.CHECKERS += (EnumChecker(enum_cls),)
         super().__init__(*pargs, **kargs)
 
+    def __set_name__(self, cls, name):
+        super().__set_name__(cls, name)
+
+        # The default is given by name, so convert it in the same manner as a set value would be.
+        if self.default is not NoValue:
+            self.default = self.enum_cls[self.default]
+
     def _set(self, obj, value):
         super()._set(obj, self.enum_cls[value])
 
@@ -252,8 +252,10 @@ class Indexer:
         for prev, field in zip(self.inc_order[:-1], self.inc_order[1:]):
             self.spans[field] = self.spans[prev] * self.fields[prev]
 
-        # Total number of indexable elements spanned by the length of the fields.
-        self.length = self.spans[-1] * self.fields[-1]
+        # Total number of indexable elements spanned by the length of the fields. This is the span
+        # of the field incremented last, multiplied by it's length.
+        last = self.inc_order[-1]
+        self.length = self.spans[last] * self.fields[last]
 
     def _to_ordinal(self, index):
         # Reduce the given index to a single integer ordinal.
@@ -0,0 +1,357 @@
+#---------------------------------------------------------------------------------------------------
+__all__ = (
+    'main',
+    'run_benchmarks',
+)
+
+import click
+import fnmatch
+import json
+import os
+import pathlib
+import platform
+import statistics
+import tempfile
+import time
+
+from regio.regmap.io import io, mmap, stream
+from regio.regmap.proxy import for_io_by_path, new_access_plan
+from regio.regmap.spec import AddressSpace, Array, Field, Register, Structure, info
+
+#---------------------------------------------------------------------------------------------------
+# Synthetic regmap used for all benchmarks. It's shaped to exercise the proxy hot paths: a deep
+# chain of nested structures for routing, a multi-word register, and a large array of registers
+# with fields for group and variable operations.
+class bench_reg(Register):
+    class lo(Field, width=16): ...
+    class hi(Field, width=16): ...
+
+class bench_level3(Structure):
+    class reg(bench_reg): ...
+
+class bench_level2(Structure):
+    class level3(bench_level3): ...
+
+class bench_level1(Structure):
+    class level2(bench_level2): ...
+
+class bench_block(Structure):
+    class reg(bench_reg): ...
+    class level1(bench_level1, offset=4): ...
+    class wide(Register, size=4, offset=8): ...
+    class tbl(Array, dimensions=(1024,), offset=1024):
+        class value(bench_reg): ...
+
+class bench_top(AddressSpace, data_width=32, pad_to=4096):
+    class blk(bench_block): ...
+
+#---------------------------------------------------------------------------------------------------
+# Backends mirror the -t/--test-io choices of the PCI tools, with file backed IO placed in a scratch
+# directory. Both flavours of memory mapped IO are included (the direct one is only distinct from
+# the indirect one when the C extension has been built).
+def _file_path(tmp_dir, name, nbytes):
+    path = pathlib.Path(tmp_dir) / f'{name}.bin'
+    with path.open('ab') as fo:
+        os.ftruncate(fo.fileno(), nbytes)
+    return path
+
+IO_TYPES = {
+    'dict': lambda spec, tmp_dir: io.DictIO(),
+    'list': lambda spec, tmp_dir: io.ListIOForSpec(spec),
+    'mmap': lambda spec, tmp_dir: mmap.FileMmapIOForSpec(
+        spec, _file_path(tmp_dir, 'mmap', info.octets_of(spec))),
+    'mmap-indirect': lambda spec, tmp_dir: mmap.MmapIndirectIO(
+        _file_path(tmp_dir, 'mmap-indirect', info.octets_of(spec)), info.data_width_of(spec),
+        mmap_size=info.octets_of(spec)),
+    'stream': lambda spec, tmp_dir: stream.FileStreamIOForSpec(
+        spec, _file_path(tmp_dir, 'stream', info.octets_of(spec))),
+    'zero': lambda spec, tmp_dir: io.ZeroIO(),
+}
+
+#---------------------------------------------------------------------------------------------------
+# Each case is a factory receiving the IO and a proxy on it. The factory returns the operation to be
+# timed along with the number of items processed per call of the operation. Cases marked as writes
+# are skipped on real hardware unless explicitly allowed.
+CASES = {}
+
+def case(name, writes=False):
+    def decorator(fn):
+        CASES[name] = (fn, writes)
+        return fn
+    return decorator
+
+@case('io.read.word')
+def _(llio, p):
+    return lambda: llio.read(1, 1), 1
+
+@case('io.write.word', writes=True)
+def _(llio, p):
+    return lambda: llio.write(1, 1, 0x5a5a5a5a), 1
+
+@case('io.update.word', writes=True)
+def _(llio, p):
+    return lambda: llio.update(1, 1, 0xffff0000, 0x1234), 1
+
+@case('io.read.bulk')
+def _(llio, p):
+    return lambda: llio.read(2, 2), 1
+
+@case('io.write.bulk', writes=True)
+def _(llio, p):
+    return lambda: llio.write(2, 2, 0x0123456789abcdef), 1
+
+@case('io.read.multi')
+def _(llio, p):
+    return lambda: llio.read(8, 4), 1
+
+@case('io.write.multi', writes=True)
+def _(llio, p):
+    return lambda: llio.write(8, 4, (1 << 127) | 0xdeadbeef), 1
+
+@case('io.update.multi', writes=True)
+def _(llio, p):
+    return lambda: llio.update(8, 4, ((1 << 128) - 1) ^ 0xff00, 0x5a00), 1
+
+@case('io.read_many.256')
+def _(llio, p):
+    offsets = list(range(1024, 1024 + 256))
+    return lambda: llio.read_many(offsets, 1), 256
+
+@case('io.write_many.256', writes=True)
+def _(llio, p):
+    offsets = list(range(1024, 1024 + 256))
+    return lambda: llio.write_many(offsets, 1, 0), 256
+
+@case('proxy.route.depth1')
+def _(llio, p):
+    return lambda: int(p.blk.reg), 1
+
+@case('proxy.route.depth4')
+def _(llio, p):
+    return lambda: int(p.blk.level1.level2.level3.reg), 1
+
+@case('proxy.route.field')
+def _(llio, p):
+    return lambda: int(p.blk.level1.level2.level3.reg.hi), 1
+
+@case('proxy.write.field', writes=True)
+def _(llio, p):
+    def op():
+        p.blk.reg.lo = 0x1234
+    return op, 1
+
+@case('proxy.group.iter.64')
+def _(llio, p):
+    return lambda: [int(v) for v in p.blk.tbl[0:64].value], 64
+
+@case('proxy.group.read.64')
+def _(llio, p):
+    return lambda: p.blk.tbl[0:64].value.hi + 0, 64
+
+@case('plan.read.200')
+def _(llio, p):
+    plan = new_access_plan(p.blk, 'tbl[0:100].value.lo', 'tbl[100:200].value.hi')
+    return plan.read, 200
+
+@case('variable.load.1024')
+def _(llio, p):
+    return lambda: p.blk.tbl(), 1024
+
+@case('variable.store.1024', writes=True)
+def _(llio, p):
+    var = p.blk.tbl(0)
+    return lambda: var.store(0), 1024
+
+@case('variable.sync.64', writes=True)
+def _(llio, p):
+    var = p.blk.tbl()
+    def op():
+        for i in range(0, 1024, 16):
+            var.proxy[i].value.lo = i
+        var.sync()
+    return op, 64
+
+#---------------------------------------------------------------------------------------------------
+def _time_op(op, min_time, repeat):
+    # Calibrate the number of calls per round such that each round lasts at least min_time.
+    number = 1
+    while True:
+        start = time.perf_counter_ns()
+        for _ in range(number):
+            op()
+        elapsed = time.perf_counter_ns() - start
+        if elapsed >= min_time * 1e9 or number >= 1 << 24:
+            break
+        number = max(number * 2, int(number * min_time * 1e9 / max(elapsed, 1)))
+
+    # Time each round, keeping the per-call duration.
+    rounds = [elapsed / number]
+    for _ in range(repeat - 1):
+        start = time.perf_counter_ns()
+        for _ in range(number):
+            op()
+        rounds.append((time.perf_counter_ns() - start) / number)
+    return number, rounds
+
+def run_benchmarks(backends, patterns=('*',), min_time=0.05, repeat=5, device=None, writes=False):
+    spec = bench_top()
+    results = []
+
+    with tempfile.TemporaryDirectory(prefix='regio-bench-') as tmp_dir:
+        targets = [(name, IO_TYPES[name](spec, tmp_dir), True) for name in backends]
+        if device is not None:
+            # A real BAR doesn't match the synthetic regmap, so only raw IO cases are run on it. The
+            # mapping covers the same range of words as the synthetic regmap.
+            dev = mmap.DevMmapIO(device, info.data_width_of(spec), mmap_size=info.octets_of(spec))
+            targets.append(('device', dev, writes))
+
+        for backend, llio, allow_writes in targets:
+            p = for_io_by_path(spec, llio)
+            with llio:
+                for name, (factory, is_write) in CASES.items():
+                    if not any(fnmatch.fnmatchcase(name, pat) for pat in patterns):
+                        continue
+                    if is_write and not allow_writes:
+                        continue
+                    if backend == 'device' and not name.startswith('io.'):
+                        continue
+
+                    op, items = factory(llio, p)
+                    number, rounds = _time_op(op, min_time, repeat)
+                    results.append({
+                        'backend': backend,
+                        'io_class': type(llio).__name__,
+                        'case': name,
+                        'items': items,
+                        'calls': number,
+                        'rounds': len(rounds),
+                        'ns_per_op': statistics.median(rounds),
+                        'ns_per_op_min': min(rounds),
+                        'ns_per_item': statistics.median(rounds) / items,
+                    })
+
+    return {
+        'meta': {
+            'python': platform.python_version(),
+            'implementation': platform.python_implementation(),
+            'machine': platform.machine(),
+            'platform': platform.platform(),
+            'mmap_ext': mmap.mmap_ext is not None,
+            'timestamp': time.strftime('%Y-%m-%dT%H:%M:%S%z'),
+            'min_time': min_time,
+            'repeat': repeat,
+        },
+        'results': results,
+    }
+
+#---------------------------------------------------------------------------------------------------
+CSV_COLUMNS = (
+    'backend', 'io_class', 'case', 'items', 'calls', 'rounds',
+    'ns_per_op', 'ns_per_op_min', 'ns_per_item',
+)
+
+def format_results(report, fmt):
+    if fmt == 'json':
+        return json.dumps(report, indent=2)
+
+    lines = []
+    if fmt == 'csv':
+        lines.append(','.join(CSV_COLUMNS))
+        for result in report['results']:
+            lines.append(','.join(str(result[column]) for column in CSV_COLUMNS))
+    else:
+        width = max([len(r['case']) for r in report['results']] + [4])
+        for result in report['results']:
+            lines.append(
+                f'{result["backend"]:14} {result["case"]:{width}} '
+                f'{result["ns_per_op"]:14,.1f} ns/op {result["ns_per_item"]:12,.1f} ns/item')
+    return '\n'.join(lines)
+
+#---------------------------------------------------------------------------------------------------
+@click.command(
+    help='''
+    Benchmark the regmap IO backends and proxy hot paths using a synthetic regmap. Results are
+    reported in nanoseconds per operation.
+    ''',
+)
+@click.option(
+    '-t', '--test-io', 'backends',
+    help='Select the IO type(s) to benchmark.',
+    type=click.Choice(('all',) + tuple(sorted(IO_TYPES))),
+    default=('all',),
+    show_default=True,
+    multiple=True,
+)
+@click.option(
+    '-d', '--device',
+    help='''
+    Also benchmark raw IO on a real PCIe BAR (such as /sys/bus/pci/devices/.../resource2). The
+    reads are made at fixed offsets within the first 16KiB of the BAR regardless of what's there,
+    so only use this on devices where reading any register has no side effects (such as clearing
+    counters or status on read).
+    ''',
+    type=click.Path(exists=True, dir_okay=False),
+)
+@click.option(
+    '--device-writes/--no-device-writes',
+    help='Allow write benchmarks on the real PCIe BAR.',
+    default=False,
+    show_default=True,
+)
+@click.option(
+    '-k', '--case', 'patterns',
+    help='Select benchmark case(s) to run by glob pattern.',
+    default=('*',),
+    show_default=True,
+    multiple=True,
+)
+@click.option(
+    '-m', '--min-time',
+    help='Minimum duration in seconds of each timing round.',
+    type=float,
+    default=0.05,
+    show_default=True,
+)
+@click.option(
+    '-r', '--repeat',
+    help='Number of timing rounds per case.',
+    type=click.IntRange(1),
+    default=5,
+    show_default=True,
+)
+@click.option(
+    '-f', '--format', 'fmt',
+    help='Output format for the results.',
+    type=click.Choice(('json', 'csv', 'text')),
+    default='json',
+    show_default=True,
+)
+@click.option(
+    '-o', '--output',
+    help='Write the results to a file instead of stdout.',
+    type=click.File('w'),
+    default='-',
+)
+@click.option(
+    '-l', '--list', 'list_cases',
+    help='List the benchmark cases and exit.',
+    is_flag=True,
+)
+def click_main(backends, device, device_writes, patterns, min_time, repeat, fmt, output,
+               list_cases):
+    if list_cases:
+        for name, (_, is_write) in CASES.items():
+            click.echo(name + (' (writes)' if is_write else ''))
+        return
+
+    if 'all' in backends:
+        backends = tuple(sorted(IO_TYPES))
+
+    report = run_benchmarks(backends, patterns, min_time, repeat, device, device_writes)
+    output.write(format_results(report, fmt) + '\n')
+
+def main():
+    click_main(auto_envvar_prefix='REGIO_BENCH')
+
+if __name__ == "__main__":
+    main()
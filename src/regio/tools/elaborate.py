@@ -3,6 +3,10 @@ __all__ = (
 )
 
 import click
+import concurrent.futures
+import copy
+import hashlib
+import os
 from pathlib import Path
 import sys
 
@@ -14,6 +18,22 @@ except ImportError:
 
 from yamlinclude import YamlIncludeConstructor
 
+from regio.tools import irbin
+
+class IncludeConstructor(YamlIncludeConstructor):
+    # Reads and parses each included file only once, no matter how many times it is referenced.
+    # Every include still produces a distinct copy of the parsed data, as it would when parsing the
+    # file again, since elaboration modifies the included definitions in place.
+    def __init__(self, *args, **kargs):
+        super().__init__(*args, **kargs)
+        self._loaded = {}
+
+    def load(self, loader, pathname, *args, **kargs):
+        key = (pathname, args, tuple(sorted(kargs.items())))
+        if key not in self._loaded:
+            self._loaded[key] = super().load(loader, pathname, *args, **kargs)
+        return copy.deepcopy(self._loaded[key])
+
 def compute_region_padding(regions, padding, min_offset=None, max_offset=None):
     merged_sorted = sorted(regions + padding, key=lambda r: r['offset'])
     if min_offset is None:
@@ -231,16 +251,103 @@ def elaborate_block(blk):
     # Elaborate the regs
     blk['regs'], blk['computed_size'] = elaborate_regs(blk['regs'])
 
-def elaborate_decoder(dec):
-    # Elaborate any referenced child blocks
+# Cached blocks are keyed by a hash of their terse definition and of this module, such that any
+# change to the elaboration rules invalidates all previously cached results.
+ELABORATOR_HASH = hashlib.sha256(Path(__file__).read_bytes()).digest()
+CACHE_SUFFIX = '.json'
+
+def block_hash(blk):
+    try:
+        data = irbin.encode(blk)
+    except (TypeError, ValueError):
+        # Not representable as JSON, so can't be compared with other blocks or cached.
+        return None
+    return hashlib.sha256(ELABORATOR_HASH + data).hexdigest()
+
+def load_cached_block(cache_dir, key):
+    if cache_dir is None:
+        return None
+    try:
+        return irbin.decode(Path(cache_dir, key + CACHE_SUFFIX).read_bytes())
+    except (OSError, ValueError):
+        return None
+
+def store_cached_block(cache_dir, key, blk):
+    if cache_dir is None:
+        return
+
+    # Write to a temporary file first, so that concurrent builds never see a partial result.
+    path = Path(cache_dir, key + CACHE_SUFFIX)
+    tmp = path.with_name(f'{path.name}.{os.getpid()}.tmp')
+    tmp.write_bytes(irbin.encode(blk))
+    os.replace(tmp, path)
+
+def elaborate_block_copy(blk):
+    # Process pool entry point, returning the elaborated block to the parent process.
+    elaborate_block(blk)
+    return blk
+
+def elaborate_blocks(blks, jobs=1, cache_dir=None):
+    # Group the blocks by their terse definitions, such that each unique block is only elaborated
+    # once, with the result copied to all blocks having the same definition.
+    groups = {}
+    for blk in blks:
+        key = block_hash(blk)
+        if key is None:
+            key = id(blk)
+        group = groups.setdefault(key, [])
+        if not any(b is blk for b in group):
+            group.append(blk)
+
+    # Skip elaborating blocks which are unchanged since a previous run.
+    results = {}
+    for key in groups:
+        if isinstance(key, str):
+            blk = load_cached_block(cache_dir, key)
+            if blk is not None:
+                results[key] = blk
+    misses = [key for key in groups if key not in results]
+
+    # Blocks are independent of each other, so can be elaborated concurrently.
+    if jobs > 1 and len(misses) > 1:
+        with concurrent.futures.ProcessPoolExecutor(max_workers=jobs) as pool:
+            elaborated = pool.map(elaborate_block_copy, [groups[key][0] for key in misses])
+            results.update(zip(misses, elaborated))
+    else:
+        for key in misses:
+            elaborate_block(groups[key][0])
+            results[key] = groups[key][0]
+
+    for key in misses:
+        if isinstance(key, str):
+            store_cached_block(cache_dir, key, results[key])
+
+    # Update the blocks in place, since they may be referenced from multiple places in the regmap.
+    for key, group in groups.items():
+        result = results[key]
+        for i, blk in enumerate(group):
+            if blk is not result:
+                blk.clear()
+                blk.update(result if i == 0 else copy.deepcopy(result))
+
+def get_decoder_blocks(dec, blks):
     if 'blocks' in dec:
+        blks.extend(dec['blocks'].values())
+    if 'decoders' in dec:
+        for _, d in dec['decoders'].items():
+            get_decoder_blocks(d, blks)
+    return blks
+
+def elaborate_decoder(dec, with_blocks=True):
+    # Elaborate any referenced child blocks, unless already done for the whole tree
+    if with_blocks and 'blocks' in dec:
         for _, blk in dec['blocks'].items():
             elaborate_block(blk)
 
     # Elaborate any referenced child decoders
     if 'decoders' in dec:
         for _, d in dec['decoders'].items():
-            elaborate_decoder(d)
+            elaborate_decoder(d, with_blocks)
 
     # Provide safe names
     safename = dec['name'].translate(name_escape)
@@ -349,9 +456,20 @@ def elaborate_decoder(dec):
 
     return
 
-def elaborate_toplevel(top):
+def elaborate_tree(dec, jobs=1, cache_dir=None):
+    # Elaborate all blocks in the decoder tree up front, then lay out the decoders around them
+    elaborate_blocks(get_decoder_blocks(dec, []), jobs, cache_dir)
+    elaborate_decoder(dec, with_blocks=False)
+
+def elaborate_toplevel(top, jobs=1, cache_dir=None):
     PAGE_SIZE = 4096
 
+    # Elaborate the blocks of all bars together, since they often share block definitions
+    blks = []
+    for _, bar in top['bars'].items():
+        get_decoder_blocks(bar['decoder'], blks)
+    elaborate_blocks(blks, jobs, cache_dir)
+
     # Provide safe names
     safename = top['name'].translate(name_escape)
     top.update({
@@ -372,7 +490,7 @@ def elaborate_toplevel(top):
 
         # Elaborate the top-level decoder
         dec = bar['decoder']
-        elaborate_decoder(dec)
+        elaborate_decoder(dec, with_blocks=False)
 
         # Promote all decoder regions up to the bar and pad it out to fill the bar
         bar['regions'] = dec['regions']
@@ -393,35 +511,56 @@ def elaborate_toplevel(top):
               default="-",
               show_default=True,
               type=click.File('w'))
+@click.option('-b', '--binary-file',
+              help="Output file for a binary (mmap-able) copy of the elaborated toplevel regmap",
+              type=click.File('wb'))
 @click.option('-f', '--file-type',
               help="Type of input yaml file",
               type=click.Choice(['top', 'block', 'decoder']),
               default='top',
               show_default=True)
+@click.option('-j', '--jobs',
+              help="Number of processes for elaborating blocks concurrently",
+              default=1,
+              show_default=True,
+              type=click.IntRange(min=1))
+@click.option('-c', '--cache-dir',
+              help="Directory for caching elaborated blocks, to skip unchanged blocks on later "
+                   "runs",
+              type=click.Path(file_okay=False, writable=True))
 @click.argument('yaml-file',
                 type=click.File('r'))
-def click_main(include_dir, output_file, file_type, yaml_file):
+def click_main(include_dir, output_file, binary_file, file_type, jobs, cache_dir, yaml_file):
     """Reads in a concise yaml regmap definition and fully
     elaborates it to produce a self-contained, verbose regmap 
     file that can be used by code generators"""
     
     if include_dir is not None:
-        YamlIncludeConstructor.add_to_loader_class(loader_class=Loader, base_dir=include_dir)
+        IncludeConstructor.add_to_loader_class(loader_class=Loader, base_dir=include_dir)
+
+    if cache_dir is not None:
+        os.makedirs(cache_dir, exist_ok=True)
 
     regmap = load(yaml_file, Loader=Loader)
 
     if file_type == "top":
         toplevel = regmap['toplevel']
-        elaborate_toplevel(toplevel)
+        elaborate_toplevel(toplevel, jobs, cache_dir)
     elif file_type == "block":
-        elaborate_block(regmap)
+        elaborate_blocks([regmap], jobs, cache_dir)
     elif file_type == "decoder":
-        elaborate_decoder(regmap)
+        elaborate_tree(regmap, jobs, cache_dir)
     else:
         pass
 
     dump(regmap, output_file, Dumper=Dumper)
 
+    if binary_file is not None:
+        if file_type != "top":
+            print("ERROR: Binary regmaps can only be produced for toplevel yaml files")
+            sys.exit(1)
+        irbin.dump(regmap, binary_file)
+
 def main(inc_dir=None):
     inc_dir = str(Path.cwd()) if inc_dir is None else inc_dir
     click.option(
@@ -3,6 +3,10 @@ __all__ = (
 )
 
 import click
+import concurrent.futures
+import hashlib
+import json
+import os
 from pathlib import Path
 import sys
 
@@ -35,6 +39,159 @@ def get_decoder_tree(root):
     })
     return decoders
 
+# Access types of the registers copied by the C snapshot and restore routines. Event registers are
+# excluded since accessing them has side effects. Only read-write registers are restored, since the
+# values of write-only registers aren't captured by snapshots.
+COPY_ACCESS = {
+    'snapshot': ('ro', 'rw', 'wr_evt'),
+    'restore':  ('rw',),
+}
+
+def block_copy_ops(blk, kind):
+    # Merge the byte ranges of consecutive registers of equal width into spans, skipping any holes
+    # and registers which aren't to be copied (such as padding).
+    spans = []
+    for reg in blk['regs']:
+        if reg['access'] not in COPY_ACCESS[kind]:
+            continue
+
+        octets = reg['width'] // 8
+        start = reg['offset']
+        end = start + octets * reg['count']
+        if spans and spans[-1][1] == start and spans[-1][2] == octets:
+            spans[-1][1] = end
+        else:
+            spans.append([start, end, octets])
+
+    # Split each span into the widest naturally aligned accesses, never narrower than the registers
+    # themselves. Consecutive accesses of equal width are grouped for emitting as loops.
+    ops = []
+    for start, end, octets in spans:
+        offset = start
+        while offset < end:
+            width = next((
+                w for w in (8, 4, 2, 1)
+                if w >= octets and offset % w == 0 and offset + w <= end
+            ), octets)
+
+            if ops and ops[-1]['width'] == width * 8 and \
+               ops[-1]['offset'] + ops[-1]['count'] * width == offset:
+                ops[-1]['count'] += 1
+            else:
+                ops.append({'offset': offset, 'width': width * 8, 'count': 1})
+            offset += width
+    return ops
+
+def make_environment(template_dir):
+    env = Environment(loader=FileSystemLoader(str(template_dir)))
+    env.add_extension('jinja2.ext.loopcontrols')
+    return env
+
+# Environment used for rendering within the current process, being either the main process or one of
+# the pool's worker processes.
+render_env = None
+
+def init_renderer(template_dir):
+    global render_env
+    render_env = make_environment(template_dir)
+
+def render_output(template, path, context, incremental):
+    if template is None:
+        text = context['text']
+    else:
+        text = render_env.get_template(template).render(**context)
+
+    # Leave outputs which are already up to date untouched, preserving their modification times.
+    if incremental:
+        try:
+            if path.read_text() == text:
+                return
+        except OSError:
+            pass
+    path.write_text(text)
+
+def encode_context(obj):
+    # Callables passed to templates are identified by name, since they're part of the generator.
+    return getattr(obj, '__qualname__', None) or repr(obj)
+
+# Digests of rendered outputs are computed over the template source, the template's context (being
+# the elaborated regmap for the output) and this module, such that any change to the generators
+# causes the affected outputs to be rendered again.
+GENERATOR_HASH = hashlib.sha256(Path(__file__).read_bytes()).digest()
+MANIFEST_NAME = '.regio-generate.json'
+
+class Renderer:
+    # Collects all outputs to be produced, then renders them together. In incremental mode, the
+    # digest of each output is recorded in a manifest within the output directory, and only outputs
+    # whose digests have changed (or which are missing) are rendered again.
+    def __init__(self, template_dir, output_dir, incremental=False, jobs=1):
+        self.template_dir = template_dir
+        self.output_dir = Path(output_dir)
+        self.incremental = incremental
+        self.jobs = jobs
+        self.outputs = []
+
+    def render(self, template, path, **context):
+        self.outputs.append((template, Path(path), context))
+
+    def write(self, path, text):
+        self.outputs.append((None, Path(path), {'text': text}))
+
+    def digest(self, template, context):
+        h = hashlib.sha256(GENERATOR_HASH)
+        if template is not None:
+            source, _, _ = render_env.loader.get_source(render_env, template)
+            h.update(source.encode())
+        h.update(json.dumps(context, default=encode_context).encode())
+        return h.hexdigest()
+
+    def load_manifest(self):
+        try:
+            with (self.output_dir / MANIFEST_NAME).open() as fo:
+                return json.load(fo)
+        except (OSError, ValueError):
+            return {}
+
+    def save_manifest(self, manifest):
+        path = self.output_dir / MANIFEST_NAME
+        tmp = path.with_name(f'{path.name}.{os.getpid()}.tmp')
+        with tmp.open(mode='w') as fo:
+            json.dump(manifest, fo, indent=2, sort_keys=True)
+        os.replace(tmp, path)
+
+    def run(self):
+        init_renderer(self.template_dir)
+
+        manifest = self.load_manifest() if self.incremental else {}
+        pending = []
+        for template, path, context in self.outputs:
+            key = str(path.relative_to(self.output_dir))
+            digest = self.digest(template, context) if self.incremental else None
+            if digest is not None and manifest.get(key) == digest and path.exists():
+                continue
+            pending.append((key, digest, template, path, context))
+
+        # Outputs are independent of each other, so can be rendered concurrently.
+        if self.jobs > 1 and len(pending) > 1:
+            with concurrent.futures.ProcessPoolExecutor(
+                    max_workers=self.jobs,
+                    initializer=init_renderer,
+                    initargs=(self.template_dir,)) as pool:
+                futures = [
+                    pool.submit(render_output, template, path, context, self.incremental)
+                    for _, _, template, path, context in pending
+                ]
+                for future in futures:
+                    future.result()
+        else:
+            for _, _, template, path, context in pending:
+                render_output(template, path, context, self.incremental)
+
+        if self.incremental:
+            for key, digest, _, _, _ in pending:
+                manifest[key] = digest
+            self.save_manifest(manifest)
+
 @click.command()
 @click.option('-t', '--template-dir',
               help="Path to the templates",
@@ -62,12 +219,22 @@ def get_decoder_tree(root):
               default=['sv', 'c'],
               show_default=True,
               multiple=True,
-              type=click.Choice(['sv', 'svh', 'c', 'py']))
+              type=click.Choice(['sv', 'svh', 'c', 'cpp', 'py']))
+@click.option('--incremental/--no-incremental',
+              help="only render outputs whose inputs or templates have changed since the previous "
+                   "run",
+              default=False,
+              show_default=True)
+@click.option('-j', '--jobs',
+              help="Number of processes for rendering outputs concurrently",
+              default=1,
+              show_default=True,
+              type=click.IntRange(min=1))
 @click.argument('yaml-file',
                 type=click.File('r'))
-def click_main(template_dir, output_dir, prefix, recursive, file_type, generators, yaml_file):
-    env = Environment(loader=FileSystemLoader(str(template_dir)))
-    env.add_extension('jinja2.ext.loopcontrols')
+def click_main(template_dir, output_dir, prefix, recursive, file_type, generators, incremental,
+               jobs, yaml_file):
+    renderer = Renderer(template_dir, output_dir, incremental, jobs)
 
     regmap = load(yaml_file, Loader=Loader)
 
@@ -108,56 +275,42 @@ def click_main(template_dir, output_dir, prefix, recursive, file_type, generator
 
         # Produce all System Verilog output files for blocks
         for _, blk in blks.items():
-            t = env.get_template('reg_pkg_sv.j2')
             outfilename = Path(output_dir) / (prefix + blk['name'] + '_reg_pkg.sv')
-            with outfilename.open(mode='w') as f:
-                t.stream(blk = blk).dump(f)
+            renderer.render('reg_pkg_sv.j2', outfilename, blk=blk)
 
-            t = env.get_template('reg_intf_sv.j2')
             outfilename = Path(output_dir) / (prefix + blk['name'] + '_reg_intf.sv')
-            with outfilename.open(mode='w') as f:
-                t.stream(blk = blk).dump(f)
+            renderer.render('reg_intf_sv.j2', outfilename, blk=blk)
             
-            t = env.get_template('reg_blk_sv.j2')
             outfilename = Path(output_dir) / (prefix + blk['name'] + '_reg_blk.sv')
-            with outfilename.open(mode='w') as f:
-                t.stream(blk = blk).dump(f)
+            renderer.render('reg_blk_sv.j2', outfilename, blk=blk)
 
         # Produce all System Verilog output files for decoders
         for _, dec in decs.items():
             dec_blks = blocks_from_regions(dec['regions'])
 
-            t = env.get_template('decoder_pkg_sv.j2')
             outfilename = Path(output_dir) / (prefix + dec['name'] + '_decoder_pkg.sv')
-            with outfilename.open(mode='w') as f:
-                t.stream(dec = dec, blks = dec_blks).dump(f)
+            renderer.render('decoder_pkg_sv.j2', outfilename, dec=dec, blks=dec_blks)
 
-            t = env.get_template('decoder_sv.j2')
             outfilename = Path(output_dir) / (prefix + dec['name'] + '_decoder.sv')
-            with outfilename.open(mode='w') as f:
-                t.stream(dec = dec, blks = dec_blks).dump(f)
+            renderer.render('decoder_sv.j2', outfilename, dec=dec, blks=dec_blks)
 
     if 'svh' in generators:
         # for svh generators, produce only the outputs for the given file type, not for dependent file types
 
         # Produce all System Verilog header files for blocks.
         for _, blk in blks.items():
-            t = env.get_template('reg_blk_agent_svh.j2')
             # Don't include prefix here.
             # These header files get bundled into verif package. The prefix is applied to the package file only.
             outfilename = Path(output_dir) / (blk['name'] + '_reg_blk_agent.svh')
-            with outfilename.open(mode='w') as f:
-                t.stream(blk = blk).dump(f)
+            renderer.render('reg_blk_agent_svh.j2', outfilename, blk=blk)
 
     if 'c' in generators:
         # for c generators, produce all relevant dependent types
 
         # Produce all C language output files
         if top is not None:
-            t = env.get_template('toplevel_c.j2')
             outfilename = Path(output_dir) / (prefix + top['name'] + '_toplevel.h')
-            with outfilename.open(mode='w') as f:
-                t.stream(top = top, blks = blks).dump(f)
+            renderer.render('toplevel_c.j2', outfilename, top=top, blks=blks)
 
         ctypes = {
              8 : "uint8_t ",
@@ -167,18 +320,38 @@ def click_main(template_dir, output_dir, prefix, recursive, file_type, generator
         }
 
         for _, blk in blks.items():
-            t = env.get_template('block_c.j2')
             outfilename = Path(output_dir) / (prefix + blk['name'] + '_block.h')
-            with outfilename.open(mode='w') as f:
-                t.stream(blk = blk, ctypes=ctypes).dump(f)
+            renderer.render(
+                'block_c.j2', outfilename, blk=blk, ctypes=ctypes, copy_ops=block_copy_ops)
 
         for _,dec in decs.items():
             dec_blks = blocks_from_regions(dec['regions'])
 
-            t = env.get_template('decoder_c.j2')
             outfilename = Path(output_dir) / (prefix + dec['name'] + '_decoder.h')
-            with outfilename.open(mode='w') as f:
-                t.stream(dec = dec, blks = dec_blks, ctypes=ctypes).dump(f)
+            renderer.render('decoder_c.j2', outfilename, dec=dec, blks=dec_blks, ctypes=ctypes)
+
+    if 'cpp' in generators:
+        # for c++ generators, produce all relevant dependent types
+
+        # Produce the support definitions shared by all C++ output files
+        outfilename = Path(output_dir) / (prefix + 'regio.hpp')
+        renderer.render('regio_cpp.j2', outfilename)
+
+        # Produce all C++ language output files
+        if top is not None:
+            outfilename = Path(output_dir) / (prefix + top['name'] + '_toplevel.hpp')
+            renderer.render('toplevel_cpp.j2', outfilename, top=top, blks=blks)
+
+        ctypes = {
+             8 : "uint8_t ",
+            16 : "uint16_t",
+            32 : "uint32_t",
+            64 : "uint64_t",
+        }
+
+        for _, blk in blks.items():
+            outfilename = Path(output_dir) / (prefix + blk['name'] + '_block.hpp')
+            renderer.render('block_cpp.j2', outfilename, blk=blk, ctypes=ctypes)
 
     if 'py' in generators:
         # for Python generators, produce all relevant dependent types
@@ -199,42 +372,34 @@ def click_main(template_dir, output_dir, prefix, recursive, file_type, generator
             #            :
             #            \-- block_N.py
             output_path /= 'python'
-            output_path.mkdir()
+            output_path.mkdir(exist_ok=incremental)
 
-            t = env.get_template('pyproject_toml.j2')
             outfilename = output_path / 'pyproject.toml'
-            with outfilename.open(mode='w') as f:
-                t.stream(top = top, blks = blks).dump(f)
+            renderer.render('pyproject_toml.j2', outfilename, top=top, blks=blks)
 
             output_path /= ('regmap_' + top['name'])
-            output_path.mkdir()
+            output_path.mkdir(exist_ok=incremental)
 
             outfilename = output_path / '__init__.py'
-            with outfilename.open(mode='w') as f:
-                f.write('# NOTE: This file was autogenerated by regio.\n')
+            renderer.write(outfilename, '# NOTE: This file was autogenerated by regio.\n')
 
-            t = env.get_template('toplevel_py.j2')
             outfilename = output_path / 'toplevel.py'
-            with outfilename.open(mode='w') as f:
-                t.stream(top = top, blks = blks).dump(f)
+            renderer.render('toplevel_py.j2', outfilename, top=top, blks=blks)
 
-            t = env.get_template('regio_py.j2')
             outfilename = output_path / 'regio.py'
-            with outfilename.open(mode='w') as f:
-                t.stream(top = top, blks = blks).dump(f)
+            renderer.render('regio_py.j2', outfilename, top=top, blks=blks)
 
             output_path /= 'blocks'
-            output_path.mkdir()
+            output_path.mkdir(exist_ok=incremental)
 
             outfilename = output_path / '__init__.py'
-            with outfilename.open(mode='w') as f:
-                f.write('# NOTE: This file was autogenerated by regio.\n')
+            renderer.write(outfilename, '# NOTE: This file was autogenerated by regio.\n')
 
         for _, blk in blks.items():
-            t = env.get_template('block_py.j2')
             outfilename = output_path / (blk['name'] + '_block.py')
-            with outfilename.open(mode='w') as f:
-                t.stream(blk = blk).dump(f)
+            renderer.render('block_py.j2', outfilename, blk=blk)
+
+    renderer.run()
 
 def main():
     click_main()
@@ -11,6 +11,8 @@ try:
 except ImportError:
     from yaml import Loader, Dumper
 
+from regio.tools import irbin
+
 def blocks_from_regions(regions):
     blks = {}
     for region in regions:
@@ -23,9 +25,16 @@ def blocks_from_regions(regions):
 
 @click.command()
 @click.argument('yaml-file',
-                type=click.File('r'))
+                type=click.Path(exists=True, dir_okay=False))
 def click_main(yaml_file):
-    regmap = load(yaml_file, Loader=Loader)
+    # Binary regmaps directly provide the list of blocks without any parsing.
+    if irbin.is_binary(yaml_file):
+        for name in irbin.BinaryRegmap(yaml_file).meta['blocks']:
+            print(name)
+        return
+
+    with open(yaml_file, 'r') as f:
+        regmap = load(f, Loader=Loader)
 
     blks = {}
     top = regmap['toplevel']
@@ -10,11 +10,7 @@ import struct
 import os
 import re
 
-from yaml import load, dump
-try:
-    from yaml import CLoader as Loader, CDumper as Dumper
-except ImportError:
-    from yaml import Loader, Dumper
+from regio.tools import irbin
 
 struct_width_map = {
      8 : "@B",
@@ -52,6 +48,83 @@ def update_field(reg_val, fld, fld_val):
 
 SYSFS_BUS_PCI_DEVICES = "/sys/bus/pci/devices"
 
+class YamlRegmap:
+    def __init__(self, path):
+        # Only pay for importing the yaml parser when actually needed.
+        from yaml import load
+        try:
+            from yaml import CLoader as Loader
+        except ImportError:
+            from yaml import Loader
+
+        with path.open('r') as f:
+            regmap = load(f, Loader=Loader)
+
+        if not "toplevel" in regmap:
+            print("ERROR: No toplevel defined in regmap.  Are you sure that's a regmap file?")
+            sys.exit(1)
+
+        toplevel = regmap['toplevel']
+        if not "bars" in toplevel:
+            print("ERROR: No bars defined in toplevel.  Are you sure that's a regmap file?")
+            sys.exit(1)
+
+        self._bars = toplevel['bars']
+        self._region_maps = {}
+
+    @property
+    def bars(self):
+        return list(self._bars)
+
+    def has_bar(self, bar):
+        return bar in self._bars
+
+    def block(self, bar, name):
+        region_map = self._region_maps.get(bar)
+        if region_map is None:
+            # Build up the block name to block instance map
+            region_map = self._region_maps[bar] = {}
+            for v in self._bars[bar]['decoder']['regions']:
+                # skip any padding blocks
+                if 'anon' in v:
+                    continue
+
+                if 'name' in v:
+                    region_map.update({ v['name'] : v })
+                else:
+                    region_map.update({ v['block']['name'] : v })
+
+        region = region_map.get(name)
+        if region is None:
+            return None
+        return region['offset'], region['block']
+
+    def register(self, bar, blk_name, reg_name):
+        found = self.block(bar, blk_name)
+        if found is None:
+            return None
+
+        # Build up the register name to register instance map
+        offset, blk = found
+        reg_map = {v['name'] : v for v in blk['regs']}
+        if reg_name not in reg_map:
+            return None
+        return offset, reg_map[reg_name]
+
+def open_regmap(path):
+    # A binary regmap is resolved without parsing the whole IR, so is preferred when given directly
+    # or when found next to the yaml file (with the same name and at least as recent).
+    path = Path(path)
+    if irbin.is_binary(path):
+        return irbin.BinaryRegmap(path)
+
+    bin_path = path.with_suffix(irbin.SUFFIX)
+    if bin_path != path and bin_path.exists() and \
+       bin_path.stat().st_mtime >= path.stat().st_mtime and irbin.is_binary(bin_path):
+        return irbin.BinaryRegmap(bin_path)
+
+    return YamlRegmap(path)
+
 @click.command()
 @click.option('-s', '--select',
               help="Select a specific PCIe device (domain:bus:device.function)",
@@ -62,27 +135,17 @@ SYSFS_BUS_PCI_DEVICES = "/sys/bus/pci/devices"
               default=2,
               show_default=True)
 @click.option('-r', '--regmap',
-              help="Path to fully elaborated regmap yaml file for this device",
+              help="Path to fully elaborated regmap yaml (or binary) file for this device",
               default='/usr/share/esnet-smartnic/esnet-smartnic-top-ir.yaml',
               show_default=True,
-              type=click.File('r'))
+              type=click.Path(exists=True, dir_okay=False))
 @click.argument('register')
 def click_main(select, bar, regmap, register):
 
-    regmap = load(regmap, Loader=Loader)
+    regmap = open_regmap(regmap)
 
-    if not "toplevel" in regmap:
-        print("ERROR: No toplevel defined in regmap.  Are you sure that's a regmap file?")
-        sys.exit(1)
-
-    toplevel = regmap['toplevel']
-    if not "bars" in toplevel:
-        print("ERROR: No bars defined in toplevel.  Are you sure that's a regmap file?")
-        sys.exit(1)
-
-    bars = toplevel['bars']
-    if not bar in bars:
-        print("ERROR: Bar {} is not defined in regmap (only {} are defined)".format(bar, ", ".join(["{:d}".format(b) for b in bars])))
+    if not regmap.has_bar(bar):
+        print("ERROR: Bar {} is not defined in regmap (only {} are defined)".format(bar, ", ".join(["{:d}".format(b) for b in regmap.bars])))
         sys.exit(1)
 
     device_path = Path(SYSFS_BUS_PCI_DEVICES) / select
@@ -144,36 +207,25 @@ def click_main(select, bar, regmap, register):
         print("ERROR: No block name specified in {}".format(lhs))
         sys.exit(1)
 
-    # Build up the block name to block instance map
-    region_map = {}
-    for i, v in enumerate(bars[bar]['decoder']['regions']):
-        # skip any padding blocks
-        if 'anon' in v:
-            continue
-
-        if 'name' in v:
-            region_map.update({ v['name'] : i })
-        else:
-            region_map.update({ v['block']['name'] : i })
-
-    if not blk_name in region_map:
-        print("ERROR: Bar {} does not contain a block called {}".format(bar, blk_name))
-        sys.exit(1)
-
-    region = bars[bar]['decoder']['regions'][region_map[blk_name]]
-    blk = region['block']
-
     if reg_name is not None:
-        # Build up the register name to register instance map
-        reg_map = {v['name'] : i for (i, v) in enumerate(blk['regs'])}
-
-        # Make sure we are referring to a valid register name in this block
-        if reg_name not in reg_map:
-            print("ERROR: Block {} does not contain a register called {}".format(blk_name, reg_name))
+        # Resolve the register directly, only falling back to the block to report errors
+        found = regmap.register(bar, blk_name, reg_name)
+        if found is None:
+            if regmap.block(bar, blk_name) is None:
+                print("ERROR: Bar {} does not contain a block called {}".format(bar, blk_name))
+            else:
+                print("ERROR: Block {} does not contain a register called {}".format(blk_name, reg_name))
             sys.exit(1)
 
-        reg = blk['regs'][reg_map[reg_name]]
+        region_offset, reg = found
+        blk = None
     else:
+        found = regmap.block(bar, blk_name)
+        if found is None:
+            print("ERROR: Bar {} does not contain a block called {}".format(bar, blk_name))
+            sys.exit(1)
+
+        region_offset, blk = found
         reg = None
 
     if fld_name is not None:
@@ -225,7 +277,7 @@ def click_main(select, bar, regmap, register):
         #
         # Ready to do a write operation
         #
-        reg_cast = build_reg_cast(mv, region['offset'], reg)
+        reg_cast = build_reg_cast(mv, region_offset, reg)
 
         for reg_index in range(*slice(slice_min, slice_max, slice_inc).indices(len(reg_cast))):
             if fld is not None:
@@ -293,15 +345,15 @@ def click_main(select, bar, regmap, register):
             print_fields(reg, v, only_fld)
 
     if reg_name is not None:
-        reg_cast = build_reg_cast(mv, region['offset'], reg)
+        reg_cast = build_reg_cast(mv, region_offset, reg)
 
         for reg_index in range(*slice(slice_min, slice_max, slice_inc).indices(len(reg_cast))):
-            print_reg(region['offset'], reg, reg_index, reg_cast[reg_index], fld)
+            print_reg(region_offset, reg, reg_index, reg_cast[reg_index], fld)
     else:
         # Print out all of the defined registers in the block
         print("[{}]".format(blk_name))
         for reg in blk['regs']:
-            offset = region['offset'] + reg['offset']
+            offset = region_offset + reg['offset']
             access = reg['access']
 
             if reg['access'] == "none":
@@ -310,10 +362,10 @@ def click_main(select, bar, regmap, register):
                 print("    {: 8x}: --------  {}".format(offset, reg['name']))
                 continue
             else:
-                reg_cast = build_reg_cast(mv, region['offset'], reg)
+                reg_cast = build_reg_cast(mv, region_offset, reg)
 
                 for reg_index in range(*slice(slice_min, slice_max, slice_inc).indices(len(reg_cast))):
-                    print_reg(region['offset'], reg, reg_index, reg_cast[reg_index], fld)
+                    print_reg(region_offset, reg, reg_index, reg_cast[reg_index], fld)
 
 def main():
     click_main(auto_envvar_prefix='REGIO')
@@ -0,0 +1,209 @@
+__all__ = (
+    'BinaryRegmap',
+    'dump',
+    'is_binary',
+)
+
+import json
+import mmap
+import struct
+
+# Compact binary serialization of an elaborated toplevel regmap, for use by tools which only need to
+# resolve a handful of names per invocation. The file is mmap'ed and a name is resolved by probing a
+# hash index, with only the records needed for the name being decoded. Nothing else is parsed.
+#
+# Layout (all integers are little endian):
+#   header:  magic, version, flags, slot count, index offset, meta offset, meta size
+#   index:   open addressed hash table of slot count entries (a power of 2), with linear probing
+#   blob:    keys and JSON encoded records referenced by the index entries and header
+#
+# Index keys are '<barid>/<region>' for blocks and '<barid>/<region>.<register>' for registers. Each
+# entry holds the absolute offset of the region within the bar, along with the record for the block
+# or register (as dicts in the elaborated IR format). Records are shared between all entries for the
+# same block or register. The meta record describes the toplevel, its bars and regions.
+MAGIC = b'REGIOIR\0'
+VERSION = 1
+SUFFIX = '.bin'
+HEADER = struct.Struct('<8sHHIQQQ')
+ENTRY = struct.Struct('<QQIIQQ') # hash, key offset, key size, record size, record offset, base
+
+FNV_OFFSET = 0xcbf29ce484222325
+FNV_PRIME = 0x100000001b3
+FNV_MASK = (1 << 64) - 1
+
+def hash_key(key):
+    h = FNV_OFFSET
+    for b in key:
+        h = ((h ^ b) * FNV_PRIME) & FNV_MASK
+    return h
+
+def is_binary(path):
+    with open(path, 'rb') as fo:
+        return fo.read(len(MAGIC)) == MAGIC
+
+# JSON only has string keys, so dicts with other keys (such as enum_hex mappings with keys parsed
+# from yaml as ints) are encoded as lists of items, preserving the key types.
+ITEMS_KEY = '__items__'
+
+def _to_json(obj):
+    if isinstance(obj, dict):
+        if all(isinstance(k, str) for k in obj):
+            return {k: _to_json(v) for k, v in obj.items()}
+        return {ITEMS_KEY: [[k, _to_json(v)] for k, v in obj.items()]}
+    if isinstance(obj, (list, tuple)):
+        return [_to_json(v) for v in obj]
+    return obj
+
+def _from_json(obj):
+    if len(obj) == 1 and ITEMS_KEY in obj:
+        return dict(obj[ITEMS_KEY])
+    return obj
+
+def encode(obj):
+    return json.dumps(_to_json(obj), separators=(',', ':')).encode()
+
+def decode(data):
+    return json.loads(data, object_hook=_from_json)
+
+def _region_name(region):
+    return region['name'] if 'name' in region else region['block']['name']
+
+def dump(regmap, fo):
+    top = regmap['toplevel']
+
+    blob = bytearray()
+    records = {}
+    def add_record(key, obj):
+        # Records are de-duplicated by identity of the underlying IR objects.
+        ref = records.get(key)
+        if ref is None:
+            data = encode(obj)
+            ref = records[key] = (len(blob), len(data))
+            blob.extend(data)
+        return ref
+
+    entries = []
+    meta = {
+        'name': top['name'],
+        'bars': {},
+        'blocks': {},
+    }
+    for barid, bar in top['bars'].items():
+        regions = []
+        for region in bar['decoder']['regions']:
+            # Skip any padding blocks.
+            if 'anon' in region:
+                continue
+
+            name = _region_name(region)
+            blk = region['block']
+            regions.append(name)
+            meta['blocks'][blk['name']] = None
+
+            key = f'{barid}/{name}'
+            entries.append((key, region['offset'], add_record(id(blk), blk)))
+            for reg in blk['regs']:
+                entries.append((
+                    f'{key}.{reg["name"]}', region['offset'], add_record(id(reg), reg)))
+
+        meta['bars'][str(barid)] = {
+            'name': bar['name'],
+            'size': bar.get('size'),
+            'regions': regions,
+        }
+    meta['blocks'] = list(meta['blocks'])
+
+    meta_offset, meta_size = add_record(None, meta)
+    keys = []
+    for key, _, _ in entries:
+        data = key.encode()
+        keys.append((len(blob), data))
+        blob.extend(data)
+
+    # Size the index for a load factor of at most 50%.
+    slot_count = 1
+    while slot_count < 2 * len(entries):
+        slot_count <<= 1
+
+    slots = [None] * slot_count
+    for (key_offset, key), (_, base, (record_offset, record_size)) in zip(keys, entries):
+        h = hash_key(key)
+        i = h & (slot_count - 1)
+        while slots[i] is not None and slots[i][1] != key:
+            i = (i + 1) & (slot_count - 1)
+
+        # Duplicate names resolve to the last definition, as for lookups in the yaml IR.
+        slots[i] = (h, key, key_offset, record_offset, record_size, base)
+
+    # Offsets into the blob are made absolute once the size of the index is known.
+    index_offset = HEADER.size
+    blob_offset = index_offset + slot_count * ENTRY.size
+    index = bytearray(slot_count * ENTRY.size)
+    for i, slot in enumerate(slots):
+        if slot is None:
+            continue
+        h, key, key_offset, record_offset, record_size, base = slot
+        ENTRY.pack_into(
+            index, i * ENTRY.size, h, blob_offset + key_offset, len(key), record_size,
+            blob_offset + record_offset, base)
+
+    fo.write(HEADER.pack(
+        MAGIC, VERSION, 0, slot_count, index_offset, blob_offset + meta_offset, meta_size))
+    fo.write(index)
+    fo.write(blob)
+
+class BinaryRegmap:
+    def __init__(self, path):
+        with open(path, 'rb') as fo:
+            try:
+                self._mm = mmap.mmap(fo.fileno(), 0, prot=mmap.PROT_READ)
+            except ValueError: # Empty file.
+                self._mm = b''
+
+        if len(self._mm) < HEADER.size:
+            raise ValueError(f'{path}: Truncated binary regmap.')
+
+        magic, version, _, self._slot_count, self._index_offset, meta_offset, meta_size = \
+            HEADER.unpack_from(self._mm)
+        if magic != MAGIC:
+            raise ValueError(f'{path}: Not a binary regmap.')
+        if version != VERSION:
+            raise ValueError(f'{path}: Unsupported binary regmap version {version}.')
+
+        self._meta_span = (meta_offset, meta_size)
+        self._meta = None
+
+    @property
+    def meta(self):
+        if self._meta is None:
+            offset, size = self._meta_span
+            self._meta = decode(self._mm[offset:offset + size])
+        return self._meta
+
+    @property
+    def bars(self):
+        return [int(barid) for barid in self.meta['bars']]
+
+    def lookup(self, key):
+        # Returns the base offset and record for the key, or None if not found.
+        key = key.encode()
+        h = hash_key(key)
+        mask = self._slot_count - 1
+        i = h & mask
+        while True:
+            entry_hash, key_offset, key_size, record_size, record_offset, base = \
+                ENTRY.unpack_from(self._mm, self._index_offset + i * ENTRY.size)
+            if key_size == 0:
+                return None
+            if entry_hash == h and self._mm[key_offset:key_offset + key_size] == key:
+                return base, decode(self._mm[record_offset:record_offset + record_size])
+            i = (i + 1) & mask
+
+    def has_bar(self, bar):
+        return str(bar) in self.meta['bars']
+
+    def block(self, bar, name):
+        return self.lookup(f'{bar}/{name}')
+
+    def register(self, bar, blk_name, reg_name):
+        return self.lookup(f'{bar}/{blk_name}.{reg_name}')
@@ -17,10 +17,20 @@ THIS_FILE = pathlib.Path(sys.argv[0])
 def test_path(pid, bid):
     return THIS_FILE.stem + f'.{pid}.bar{bid}.bin'
 
+def trace_path(pid, bid):
+    return THIS_FILE.stem + f'.{pid}.bar{bid}.trace'
+
+def shm_name(pid, bid):
+    return THIS_FILE.stem + f'.{pid}.bar{bid}'
+
 IO_TYPES = {
     'dict': lambda spec, pid, bid: DictIO(),
     'list': lambda spec, pid, bid: ListIOForSpec(spec),
     'mmap': lambda spec, pid, bid: FileMmapIOForSpec(spec, test_path(pid, bid)),
+    'replay': lambda spec, pid, bid: ReplayIO(trace_path(pid, bid)),
+    'shm': lambda spec, pid, bid: ShmIOForSpec(spec, shm_name(pid, bid)),
+    'shm-doorbell': lambda spec, pid, bid: ShmIOForSpec(
+        spec, shm_name(pid, bid), doorbell_depth=1024, doorbell_sync=True, timeout=10),
     'stream': lambda spec, pid, bid: FileStreamIOForSpec(spec, test_path(pid, bid)),
     'zero': lambda spec, pid, bid: ZeroIO(),
 }
@@ -39,6 +49,32 @@ def pci_device_ids(vendor_id, device_id):
         if _hex_to_int(dev / 'vendor') == vendor_id and _hex_to_int(dev / 'device') == device_id
     ))
 
+# NUMA node of a device, or None when the platform doesn't report one.
+def pci_numa_node(pci_id):
+    with (PCI_DEVICES_DIR / pci_id / 'numa_node').open('r') as fo:
+        node = int(fo.read())
+    return None if node < 0 else node
+
+# CPUs local to the NUMA node of a device, parsed from a list of ranges such as '0-7,16-23'.
+def pci_local_cpus(pci_id):
+    with (PCI_DEVICES_DIR / pci_id / 'local_cpulist').open('r') as fo:
+        text = fo.read().strip()
+
+    cpus = set()
+    for part in text.split(','):
+        first, _, last = part.partition('-')
+        cpus.update(range(int(first), int(last or first) + 1))
+    return frozenset(cpus)
+
+def new_dev_io(pci_id, bar_id, spec, populate=False, numa=False):
+    # Map a device's BAR. With numa, threads can bind to the device's local CPUs while accessing it
+    # (see MmapIO.bind_local_cpus).
+    cpus = None
+    if numa and pci_numa_node(pci_id) is not None:
+        cpus = pci_local_cpus(pci_id)
+    return DevMmapIOForSpec(
+        spec, PCI_DEVICES_DIR / pci_id / f'resource{bar_id}', populate=populate, cpus=cpus)
+
 #---------------------------------------------------------------------------------------------------
 def new_click_main(top):
     BAR_IDS = tuple(sorted(top.BAR_INFO))
@@ -79,9 +115,33 @@ def new_click_main(top):
         help='Run in test mode using an alternate IO type independent of hardware.',
         type=click.Choice(tuple(sorted(IO_TYPES))),
     )
+    @click.option(
+        '--populate',
+        help='Pre-fault the page tables of the mapped PCIe BAR(s) when starting.',
+        is_flag=True,
+        default=False,
+    )
+    @click.option(
+        '--numa',
+        help='''
+        Bind the threads accessing each PCIe device to the CPUs local to its NUMA node while
+        starting, stopping, dumping and capturing snapshots.
+        ''',
+        is_flag=True,
+        default=False,
+    )
+    @click.option(
+        '--record',
+        help='''
+        Record a trace of all IO made on each selected PCIe device and BAR, for replaying later with
+        the replay test IO type. Traces are written to files in the current directory.
+        ''',
+        is_flag=True,
+        default=False,
+    )
     @ClickEnvironment.main_options
     @click.pass_context
-    def click_main(ctx, pci_ids, bar_ids, test_io, **env_kargs):
+    def click_main(ctx, pci_ids, bar_ids, test_io, populate, numa, record, **env_kargs):
         if 'all' in pci_ids:
             pci_ids = PCI_IDS
 
@@ -107,8 +167,16 @@ def new_click_main(top):
 
             # Create the proxy on the BAR(s).
             for bid in bar_ids:
-                io = None if io_type is None else io_type(specs[bid], pid, bid)
+                if io_type is not None:
+                    io = io_type(specs[bid], pid, bid)
+                elif populate or numa:
+                    io = new_dev_io(pid, bid, specs[bid], populate, numa)
+                else:
+                    io = None
                 proxy = top.BAR_INFO[bid]['new_proxy'](pid, specs[bid], io, **proxy_kargs)
+                if record and not env.in_completion:
+                    pctx = proxy.___context___
+                    pctx.io = TracingIO(pctx.io, path=trace_path(pid, bid))
                 setattr(dev, f'bar{bid}', proxy)
 
         # Invoked for command line completion, so don't do anything more.
@@ -135,7 +203,7 @@ def new_proxy(pci_id, bar_id, spec_cls, spec=None, io=None, *pargs, **kargs):
 
     # Create the low-level IO accessor for the device.
     if io is None:
-        io = DevMmapIOForSpec(spec, PCI_DEVICES_DIR / pci_id / f'resource{bar_id}')
+        io = new_dev_io(pci_id, bar_id, spec)
 
     # Create the proxy.
     return for_io_by_path(spec, io, *pargs, **kargs)